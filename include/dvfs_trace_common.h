@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * dvfs_trace_common.h: sched_cpufreq、cpufreq_ctl、cpufreq_sim 共用的调频来源编号与 dvfs_freq_* 事件布局
+ *
+ * 三个模块的 dvfs_freq_* 事件使用相同的事件名、字段和来源编号，可用 '*:dvfs_freq_*' 跨模块关联。
+ * 只能在各模块 trace 头文件的 TRACE_HEADER_MULTI_READ 区域内包含；Makefile 中需 -I$(src)/../include。
+ */
+
+#ifndef _DVFS_TRACE_COMMON_H
+#define _DVFS_TRACE_COMMON_H
+
+#define DVFS_SRC_IOCTL      0   /* cpufreq_ctl 直接设频 */
+#define DVFS_SRC_QOS        1   /* cpufreq_ctl freq_qos 请求 */
+#define DVFS_SRC_SWITCH     2   /* sched_cpufreq RT 任务切入 */
+#define DVFS_SRC_PREDICT    3   /* sched_cpufreq 预调频定时器 */
+#define DVFS_SRC_TARGET     4   /* cpufreq_sim ->target_index */
+#define DVFS_SRC_FAST       5   /* cpufreq_sim ->fast_switch */
+#define DVFS_SRC_OTHER      6   /* governor、thermal 等其它来源 */
+
+#define show_dvfs_src(src) __print_symbolic(src,    \
+    { DVFS_SRC_IOCTL,   "ioctl" },                  \
+    { DVFS_SRC_QOS,     "qos" },                    \
+    { DVFS_SRC_SWITCH,  "switch" },                 \
+    { DVFS_SRC_PREDICT, "predict" },                \
+    { DVFS_SRC_TARGET,  "target" },                 \
+    { DVFS_SRC_FAST,    "fast" },                   \
+    { DVFS_SRC_OTHER,   "other" })
+
+/* 在各模块 trace 头文件中声明事件：DEFINE_DVFS_FREQ_REQUEST_EVENT(dvfs_freq_request); */
+#define DEFINE_DVFS_FREQ_REQUEST_EVENT(name)                                            \
+DEFINE_EVENT(dvfs_freq_request, name,                                                   \
+    TP_PROTO(unsigned int cpu, unsigned int old_freq, unsigned int new_freq, int source), \
+    TP_ARGS(cpu, old_freq, new_freq, source))
+
+#define DEFINE_DVFS_FREQ_DONE_EVENT(name)                                               \
+DEFINE_EVENT(dvfs_freq_done, name,                                                      \
+    TP_PROTO(unsigned int cpu, unsigned int old_freq, unsigned int new_freq, int source, \
+             u64 latency_ns, int ret),                                                  \
+    TP_ARGS(cpu, old_freq, new_freq, source, latency_ns, ret))
+
+/* 事件启用/停用时回调 reg/unreg，用于按需挂接事件的数据来源 */
+#define DEFINE_DVFS_FREQ_DONE_EVENT_FN(name, reg, unreg)                                \
+DEFINE_EVENT_FN(dvfs_freq_done, name,                                                   \
+    TP_PROTO(unsigned int cpu, unsigned int old_freq, unsigned int new_freq, int source, \
+             u64 latency_ns, int ret),                                                  \
+    TP_ARGS(cpu, old_freq, new_freq, source, latency_ns, ret), reg, unreg)
+
+#endif /* _DVFS_TRACE_COMMON_H */
+
+/* 事件类在 define_trace.h 的每一遍读入中都要展开，不受上面的 include guard 保护 */
+
+/* 提交请求：old 为目标 CPU 当前频率，new 为请求频率 */
+DECLARE_EVENT_CLASS(dvfs_freq_request,
+
+    TP_PROTO(unsigned int cpu, unsigned int old_freq, unsigned int new_freq, int source),
+
+    TP_ARGS(cpu, old_freq, new_freq, source),
+
+    TP_STRUCT__entry(
+        __field(unsigned int,   cpu)
+        __field(unsigned int,   old_freq)
+        __field(unsigned int,   new_freq)
+        __field(int,            source)
+    ),
+
+    TP_fast_assign(
+        __entry->cpu      = cpu;
+        __entry->old_freq = old_freq;
+        __entry->new_freq = new_freq;
+        __entry->source   = source;
+    ),
+
+    TP_printk("cpu=%u old=%u new=%u source=%s",
+              __entry->cpu, __entry->old_freq, __entry->new_freq,
+              show_dvfs_src(__entry->source))
+);
+
+/* 请求执行完毕或驱动完成切换：latency_ns 的起点由各事件定义，ret 为返回码 */
+DECLARE_EVENT_CLASS(dvfs_freq_done,
+
+    TP_PROTO(unsigned int cpu, unsigned int old_freq, unsigned int new_freq, int source,
+             u64 latency_ns, int ret),
+
+    TP_ARGS(cpu, old_freq, new_freq, source, latency_ns, ret),
+
+    TP_STRUCT__entry(
+        __field(unsigned int,   cpu)
+        __field(unsigned int,   old_freq)
+        __field(unsigned int,   new_freq)
+        __field(int,            source)
+        __field(u64,            latency_ns)
+        __field(int,            ret)
+    ),
+
+    TP_fast_assign(
+        __entry->cpu        = cpu;
+        __entry->old_freq   = old_freq;
+        __entry->new_freq   = new_freq;
+        __entry->source     = source;
+        __entry->latency_ns = latency_ns;
+        __entry->ret        = ret;
+    ),
+
+    TP_printk("cpu=%u old=%u new=%u source=%s latency_ns=%llu ret=%d",
+              __entry->cpu, __entry->old_freq, __entry->new_freq,
+              show_dvfs_src(__entry->source), __entry->latency_ns, __entry->ret)
+);
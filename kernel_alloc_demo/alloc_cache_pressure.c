@@ -0,0 +1,205 @@
+// alloc_cache_pressure.c
+// Build: gcc -O2 -o alloc_cache_pressure alloc_cache_pressure.c
+// Purpose: drive alloc_demo's reclaimable cache (action=cache_access) while a child process
+//          generates memory pressure, and print hit rate / reclaim / shrinker scan cost per second.
+//
+//   sudo alloc_cache_pressure <pressure_mb> <seconds> [lookups_per_tick=1000]
+//
+// 缓存对象的 mode/size 以及 cache_keys 沿用 /sys/kernel/alloc_demo 中的当前设置。
+// 前 1/4 时间（最多 5 秒）只访问缓存预热，之后子进程反复写满 pressure_mb 的匿名内存，
+// 迫使内核回收并调用模块的 shrinker。
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define SYSFS  "/sys/kernel/alloc_demo"
+#define PROC   "/proc/alloc_demo"
+
+#define TICK_MS 100
+
+/* /proc/alloc_demo 中 cache 段的计数 */
+struct cache_snap {
+    unsigned long objs;
+    unsigned long long bytes;
+    unsigned long lookups, hits, misses;
+    unsigned long long miss_ns;
+    unsigned long reclaimed, scan_calls;
+    unsigned long long scan_ns, scan_max_ns;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int sysfs_write(const char *attr, const char *val)
+{
+    char path[128];
+    int fd, ret = 0;
+
+    snprintf(path, sizeof(path), SYSFS "/%s", attr);
+    fd = open(path, O_WRONLY);
+    if (fd < 0)
+        return -errno;
+    if (write(fd, val, strlen(val)) < 0)
+        ret = -errno;
+    close(fd);
+    return ret;
+}
+
+static int read_snap(struct cache_snap *s)
+{
+    char line[256];
+    unsigned long fill_fails, dropped, count_calls, scan_req;
+    unsigned long long avg, p50, p99, max;
+    int found = 0;
+    FILE *f = fopen(PROC, "r");
+
+    if (!f)
+        return -1;
+    memset(s, 0, sizeof(*s));
+    while (fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, "cache ", 6))
+            found = 1;
+        if (!found)
+            continue;
+        sscanf(line, " objs: %lu bytes: %llu", &s->objs, &s->bytes);
+        sscanf(line, " lookups: %lu hits: %lu misses: %lu fill_fails: %lu",
+               &s->lookups, &s->hits, &s->misses, &fill_fails);
+        sscanf(line, " miss_ns: total %llu", &s->miss_ns);
+        sscanf(line, " reclaimed: %lu dropped: %lu count_calls: %lu scan_calls: %lu scan_requested: %lu",
+               &s->reclaimed, &dropped, &count_calls, &s->scan_calls, &scan_req);
+        if (sscanf(line, " scan_ns: total %llu avg %llu p50 <%llu p99 <%llu max %llu",
+                   &s->scan_ns, &avg, &p50, &p99, &max) == 5) {
+            s->scan_max_ns = max;
+            break;
+        }
+    }
+    fclose(f);
+    return found ? 0 : -1;
+}
+
+/* 子进程：反复写满 pressure_mb 的匿名内存，直到被杀掉 */
+static void pressure_loop(size_t bytes)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    char *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    unsigned char v = 0;
+    size_t off;
+
+    if (p == MAP_FAILED) {
+        perror("mmap pressure");
+        _exit(1);
+    }
+    for (;;) {
+        for (off = 0; off < bytes; off += page)
+            p[off] = v;
+        v++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long pressure_mb, seconds, lookups;
+    struct cache_snap prev, cur;
+    char val[32];
+    pid_t child = -1;
+    uint64_t t_start, next_tick, next_report, warm_ns;
+    unsigned long sec = 0;
+    int ret;
+
+    if (argc < 3 || argc > 4) {
+        fprintf(stderr, "Usage: sudo %s <pressure_mb> <seconds> [lookups_per_tick=1000]\n", argv[0]);
+        return 1;
+    }
+    pressure_mb = strtoul(argv[1], NULL, 0);
+    seconds = strtoul(argv[2], NULL, 0);
+    lookups = argc > 3 ? strtoul(argv[3], NULL, 0) : 1000;
+    if (!seconds || !lookups) {
+        fprintf(stderr, "seconds and lookups_per_tick must be > 0\n");
+        return 1;
+    }
+
+    snprintf(val, sizeof(val), "%lu", lookups);
+    ret = sysfs_write("count", val);
+    if (!ret)
+        ret = sysfs_write("action", "reset_stats");
+    if (ret || read_snap(&prev)) {
+        fprintf(stderr, "cannot use " SYSFS ": %s\n", ret ? strerror(-ret) : "no cache section in " PROC);
+        return 1;
+    }
+
+    warm_ns = (seconds < 20 ? seconds : 20) * 250000000ull;
+    printf("pressure=%lu MiB seconds=%lu lookups/tick=%lu tick=%dms warmup=%llus\n",
+           pressure_mb, seconds, lookups, TICK_MS, (unsigned long long)(warm_ns / 1000000000ull));
+    printf("%4s %8s %10s %7s %10s %10s %12s %12s %12s\n", "sec", "phase", "objs", "MiB", "hit%",
+           "reclaimed", "scan_calls", "scan_avg_us", "miss_avg_us");
+
+    t_start = now_ns();
+    next_tick = t_start;
+    next_report = t_start + 1000000000ull;
+    while (now_ns() - t_start < seconds * 1000000000ull) {
+        uint64_t now;
+
+        /* 压力进程被 OOM killer 杀掉后重新拉起 */
+        if (child > 0 && waitpid(child, NULL, WNOHANG) == child)
+            child = -1;
+        if (child < 0 && pressure_mb && now_ns() - t_start >= warm_ns) {
+            child = fork();
+            if (child == 0)
+                pressure_loop(pressure_mb << 20);
+            if (child < 0)
+                perror("fork");
+        }
+
+        ret = sysfs_write("action", "cache_access");
+        if (ret) {
+            fprintf(stderr, "cache_access: %s\n", strerror(-ret));
+            break;
+        }
+
+        now = now_ns();
+        if (now >= next_report && !read_snap(&cur)) {
+            unsigned long lk = cur.lookups - prev.lookups;
+            unsigned long filled = cur.misses - prev.misses;
+            unsigned long scans = cur.scan_calls - prev.scan_calls;
+
+            printf("%4lu %8s %10lu %7.1f %10.1f %10lu %12lu %12.1f %12.1f\n", ++sec,
+                   child > 0 ? "pressure" : "warmup", cur.objs, cur.bytes / 1048576.0,
+                   lk ? 100.0 * (cur.hits - prev.hits) / lk : 0.0,
+                   cur.reclaimed - prev.reclaimed, scans,
+                   scans ? (cur.scan_ns - prev.scan_ns) / 1000.0 / scans : 0.0,
+                   filled ? (cur.miss_ns - prev.miss_ns) / 1000.0 / filled : 0.0);
+            fflush(stdout);
+            prev = cur;
+            next_report += 1000000000ull;
+        }
+
+        next_tick += TICK_MS * 1000000ull;
+        now = now_ns();
+        if (next_tick > now)
+            usleep((next_tick - now) / 1000);
+    }
+
+    if (child > 0) {
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+    }
+    if (!read_snap(&cur))
+        printf("total: lookups %lu hit%% %.1f reclaimed %lu scan_calls %lu scan_total_ms %.2f scan_max_us %.1f\n",
+               cur.lookups, cur.lookups ? 100.0 * cur.hits / cur.lookups : 0.0, cur.reclaimed,
+               cur.scan_calls, cur.scan_ns / 1e6, cur.scan_max_ns / 1000.0);
+    return 0;
+}
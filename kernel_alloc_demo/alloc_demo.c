@@ -1,6 +1,9 @@
 // alloc_demo.c
 // Build: use provided Makefile
 // Purpose: Demonstrate kmalloc / alloc_pages / vmalloc, provide sysfs control and proc output.
+//          Huge modes: PMD-sized compound pages, vmalloc_huge (5.18+), alloc_contig_pages (make CONTIG=1).
+//          /dev/alloc_demo lets userspace mmap any live allocation (offset = record index * PAGE_SIZE).
+//          Cache mode: keyed objects on an LRU, reclaimed by the kernel through a shrinker.
 
 #include <linux/module.h>
 #include <linux/init.h>
@@ -16,10 +19,23 @@
 #include <linux/uaccess.h>
 #include <linux/mutex.h>
 #include <linux/version.h>     // for LINUX_VERSION_CODE
+#include <linux/ktime.h>
+#include <linux/fs.h>
+#include <linux/cdev.h>
+#include <linux/device.h>
+#include <linux/atomic.h>
+#include <linux/list.h>
+#include <linux/hashtable.h>
+#include <linux/spinlock.h>
+#include <linux/shrinker.h>
+#include <linux/random.h>
+
+#define CREATE_TRACE_POINTS
+#include "alloc_demo_trace.h"
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("zs");
-MODULE_DESCRIPTION("Demo module: kmalloc / alloc_pages / vmalloc differences (sysfs + procfs)");
+MODULE_DESCRIPTION("Demo module: kmalloc / alloc_pages / vmalloc / huge allocation differences (sysfs + procfs)");
 MODULE_VERSION("1.0");
 
 /* ---------- configuration and state ---------- */
@@ -28,9 +44,50 @@ enum alloc_mode {
     MODE_KMALLOC = 0,
     MODE_ALLOC_PAGES = 1,
     MODE_VMALLOC = 2,
+    MODE_COMPOUND = 3,      /* __GFP_COMP, 至少 PMD 大小（order 9 @ 4K 页） */
+    MODE_VMALLOC_HUGE = 4,  /* vmalloc_huge()，5.18+ 且架构支持时用 PMD 映射 */
+    MODE_CONTIG = 5,        /* alloc_contig_pages()，需要 make CONTIG=1 */
+    MODE_NR,
+};
+
+static const char *mode_names[] = {
+    "kmalloc", "alloc_pages", "vmalloc", "compound", "vmalloc_huge", "contig",
 };
 
-static const char *mode_names[] = { "kmalloc", "alloc_pages", "vmalloc" };
+/* PMD 映射对应的页阶 */
+#define HUGE_ORDER (PMD_SHIFT - PAGE_SHIFT)
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,18,0)
+#define HAVE_VMALLOC_HUGE 1
+#endif
+
+/* 伙伴分配器允许的最大页阶：6.4 起 MAX_ORDER 含端点，6.8 改名 MAX_PAGE_ORDER */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,8,0)
+#define ALLOC_DEMO_MAX_ORDER MAX_PAGE_ORDER
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(6,4,0)
+#define ALLOC_DEMO_MAX_ORDER MAX_ORDER
+#else
+#define ALLOC_DEMO_MAX_ORDER (MAX_ORDER - 1)
+#endif
+
+/*
+ * alloc_contig_pages()/free_contig_range() 依赖 CONFIG_CONTIG_ALLOC 且未导出给模块，
+ * make CONTIG=1 仅用于导出了这两个符号的内核。
+ */
+#ifdef ALLOC_DEMO_CONTIG
+#define HAVE_CONTIG_ALLOC 1
+#endif
+
+/* 每种模式的累计统计 */
+struct mode_stats {
+    unsigned long ok;
+    unsigned long fail;
+    u64 lat_sum_ns;
+    u64 lat_min_ns;
+    u64 lat_max_ns;
+    unsigned long pmd_aligned_runs; /* 虚拟/物理都 PMD 对齐且物理连续的 PMD 大小块数（推断，非页表实测） */
+    unsigned long other_pages;      /* 不在上述块内的页数 */
+};
 
 /* Controlled via sysfs: mode,size,count,action */
 static int cur_mode = MODE_KMALLOC;
@@ -40,7 +97,7 @@ static int cur_count = 1;        /* how many allocations to perform */
 struct alloc_rec {
     void *ptr;          /* pointer returned to us (vaddr or page_address)：内核内存分配接口返回给我们的实际虚拟地址 */
     struct page *page;  /* only used when alloc_pages returns page */
-    size_t size;        /* requested size */
+    size_t size;        /* requested size (compound: actual size of the compound page) */
     int mode;
 };
 
@@ -50,6 +107,7 @@ struct alloc_demo_state {
     int alloc_used;
     unsigned long success_count;
     unsigned long fail_count;
+    struct mode_stats stats[MODE_NR];
     struct mutex lock;
 } state;
 
@@ -59,32 +117,320 @@ static struct kobject *alloc_kobj;
 /* proc entry name */
 #define PROC_NAME "alloc_demo"
 
+/* mmap device */
+#define DEVICE_NAME "alloc_demo"
+#define CLASS_NAME  "alloc_demo"
+
+static struct class *alloc_class;
+static struct cdev alloc_cdev;
+static dev_t alloc_devt;
+
+/*
+ * 活跃的用户映射数。kmalloc/alloc_pages 经 remap_pfn_range 映射，页不带引用计数，
+ * 存在映射时释放会让用户态访问到已释放的内存，因此有映射时拒绝 free。
+ */
+static atomic_t nr_mmaps = ATOMIC_INIT(0);
+
+/* ---------- trace replay ---------- */
+
+/* 二进制 trace 中的一条操作，按顺序写入 /sys/kernel/alloc_demo/replay */
+struct replay_op {
+    u8 op;              /* REPLAY_OP_ALLOC / REPLAY_OP_FREE */
+    u8 mode;            /* enum alloc_mode，仅 alloc 使用 */
+    u16 reserved;
+    u32 id;             /* 对象标识：free 释放同 id 的最近一次 alloc */
+    u64 size;           /* 字节数，仅 alloc 使用 */
+};
+
+#define REPLAY_OP_ALLOC     1
+#define REPLAY_OP_FREE      2
+#define REPLAY_MAX_BYTES    (64UL << 20)    /* 最多 4M 条操作 */
+#define REPLAY_MAX_ID       (1U << 22)
+#define REPLAY_HIST         32              /* 延迟 log2(ns) 分桶 */
+
+/* 最近一次回放的结果 */
+struct replay_result {
+    int ret;                    /* 0 或 trace 校验/执行错误 */
+    unsigned long ops;
+    unsigned long allocs;
+    unsigned long frees;
+    unsigned long fails;        /* 分配失败 */
+    unsigned long bad_ops;      /* 对存活 id 再次 alloc、或 free 不存在的 id，跳过 */
+    unsigned long leaked;       /* trace 结束时仍存活、由模块回收的对象 */
+    u64 elapsed_ns;
+    u64 alloc_ns;
+    u64 alloc_max_ns;
+    u64 free_ns;
+    u64 free_max_ns;
+    unsigned long alloc_hist[REPLAY_HIST];
+    unsigned long free_hist[REPLAY_HIST];
+    size_t cur_bytes;
+    size_t peak_bytes;
+    unsigned long cur_objs;
+    unsigned long peak_objs;
+};
+
+/* 以下均由 state.lock 保护 */
+static void *replay_buf;
+static size_t replay_len;
+static size_t replay_cap;
+static struct replay_result replay_res;
+
+/* ---------- reclaimable object cache ---------- */
+
+/*
+ * action=cache_access 按 key 查找 count 次，未命中时用当前 mode/size 分配一个对象并放到 LRU 头部。
+ * 对象不进 state.recs，内存紧张时由 shrinker 从 LRU 尾部回收。
+ */
+struct cache_obj {
+    struct list_head lru;       /* 头部为最近使用 */
+    struct hlist_node node;
+    u32 key;
+    struct alloc_rec rec;
+};
+
+struct cache_stats {
+    unsigned long lookups;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long fill_fails;
+    unsigned long reclaimed;    /* shrinker 回收的对象数 */
+    unsigned long dropped;      /* action=cache_drop 释放的对象数 */
+    unsigned long scan_calls;
+    unsigned long scan_requested;   /* nr_to_scan 之和 */
+    u64 miss_ns;                /* 未命中路径：分配 + 填充 */
+    u64 miss_max_ns;
+    u64 scan_ns;                /* scan_objects 回调耗时 */
+    u64 scan_max_ns;
+    unsigned long miss_hist[REPLAY_HIST];
+    unsigned long scan_hist[REPLAY_HIST];
+};
+
+#define CACHE_HASH_BITS     12
+#define CACHE_MAX_KEYS      (1U << 24)
+
+/*
+ * cache_lock 保护哈希表、LRU 和 cache_stats。shrinker 在回收路径中只取这把自旋锁；
+ * 访问路径持有 state.lock 时在自旋锁外分配，直接回收进入 shrinker 也不会死锁。
+ */
+static DEFINE_SPINLOCK(cache_lock);
+static DEFINE_HASHTABLE(cache_hash, CACHE_HASH_BITS);
+static LIST_HEAD(cache_lru);
+static unsigned long cache_nr;
+static size_t cache_bytes;
+static struct cache_stats cache_stats;
+static atomic_long_t cache_count_calls = ATOMIC_LONG_INIT(0);
+static unsigned int cache_keys = 4096;  /* sysfs: key 空间大小 */
+static struct shrinker *cache_shrinker;
+
 /* ---------- utilities ---------- */
 
-static void free_record(struct alloc_rec *r)
+static bool mode_supported(int mode)
 {
-    if (!r || !r->ptr)
+    switch (mode) {
+    case MODE_VMALLOC_HUGE:
+        return IS_ENABLED(HAVE_VMALLOC_HUGE);
+    case MODE_CONTIG:
+        return IS_ENABLED(HAVE_CONTIG_ALLOC);
+    default:
+        return mode >= 0 && mode < MODE_NR;
+    }
+}
+
+static bool mode_is_vmalloc(int mode)
+{
+    return mode == MODE_VMALLOC || mode == MODE_VMALLOC_HUGE;
+}
+
+static const char *mode_name(int mode)
+{
+    return (mode >= 0 && mode < MODE_NR) ? mode_names[mode] : "unknown";
+}
+
+/* 分配所在的 NUMA 节点，vmalloc 取首页所在节点 */
+static int alloc_node(int mode, void *ptr, struct page *page)
+{
+    switch (mode) {
+    case MODE_KMALLOC:
+        return page_to_nid(virt_to_page(ptr));
+    case MODE_ALLOC_PAGES:
+    case MODE_COMPOUND:
+    case MODE_CONTIG:
+        return page_to_nid(page);
+    case MODE_VMALLOC:
+    case MODE_VMALLOC_HUGE:
+        return page_to_nid(vmalloc_to_page(ptr));
+    default:
+        return NUMA_NO_NODE;
+    }
+}
+
+static unsigned long addr_to_pfn(int mode, const void *addr)
+{
+    return mode_is_vmalloc(mode) ? page_to_pfn(vmalloc_to_page(addr))
+                                 : virt_to_phys(addr) >> PAGE_SHIFT;
+}
+
+/*
+ * 统计 PMD 对齐的物理连续块：虚拟地址 PMD 对齐、物理上连续且 PFN 同样 PMD 对齐的 2M 块
+ * 计为一个 run，其余计入 other_pages。这只说明“可以”用一个 PMD 映射，不代表实际如此：
+ * 不读页表，arm64 rodata=full / DEBUG_PAGEALLOC 下的线性映射、用 PTE 映射的 vmalloc 区都会被高估。
+ * 对 vmalloc 逐页 vmalloc_to_page。
+ */
+static void count_page_sizes(int mode, void *ptr, size_t size, struct mode_stats *st)
+{
+    unsigned long start = (unsigned long)ptr;
+    unsigned long end = start + PAGE_ALIGN(size);
+    unsigned long addr = ALIGN(start, PMD_SIZE);
+    unsigned long covered = 0;
+
+    for (; addr + PMD_SIZE <= end; addr += PMD_SIZE) {
+        unsigned long pfn = addr_to_pfn(mode, (void *)addr);
+        unsigned long off;
+
+        if (!IS_ALIGNED(pfn, 1UL << HUGE_ORDER))
+            continue;
+        for (off = PAGE_SIZE; off < PMD_SIZE; off += PAGE_SIZE) {
+            if (addr_to_pfn(mode, (void *)(addr + off)) != pfn + (off >> PAGE_SHIFT))
+                break;
+        }
+        if (off == PMD_SIZE) {
+            st->pmd_aligned_runs++;
+            covered += PMD_SIZE;
+        }
+    }
+    st->other_pages += (PAGE_ALIGN(size) - covered) >> PAGE_SHIFT;
+}
+
+static void account_alloc(int mode, void *ptr, size_t size, u64 latency)
+{
+    struct mode_stats *st = &state.stats[mode];
+
+    if (!ptr) {
+        st->fail++;
         return;
+    }
+    st->ok++;
+    st->lat_sum_ns += latency;
+    if (!st->lat_min_ns || latency < st->lat_min_ns)
+        st->lat_min_ns = latency;
+    if (latency > st->lat_max_ns)
+        st->lat_max_ns = latency;
+    count_page_sizes(mode, ptr, size, st);
+}
+
+/* 释放一条记录，返回释放耗时 */
+static u64 free_record(struct alloc_rec *r)
+{
+    int node;
+    u64 t0, latency;
 
+    if (!r || !r->ptr)
+        return 0;
+
+    node = alloc_node(r->mode, r->ptr, r->page);
+    t0 = ktime_get_ns();
     switch (r->mode) {
     case MODE_KMALLOC:
         kfree(r->ptr);
         break;
     case MODE_VMALLOC:
+    case MODE_VMALLOC_HUGE:
         vfree(r->ptr);
         break;
     case MODE_ALLOC_PAGES:
+    case MODE_COMPOUND:
         if (r->page) {
             int order = get_order(r->size);
             __free_pages(r->page, order);
         }
         break;
+#ifdef HAVE_CONTIG_ALLOC
+    case MODE_CONTIG:
+        free_contig_range(page_to_pfn(r->page), PAGE_ALIGN(r->size) >> PAGE_SHIFT);
+        break;
+#endif
     default:
         break;
     }
+    latency = ktime_get_ns() - t0;
+    trace_alloc_demo_free(r->mode, r->size, r->ptr, node, latency);
 
     r->ptr = NULL;
     r->page = NULL;
+    return latency;
+}
+
+/*
+ * 按 mode 分配 size 字节并填写 r（失败时 r->ptr 为 NULL），触发 tracepoint，不更新模式统计。
+ * 返回分配耗时，只计分配器调用本身。调用者持有 state.lock。
+ */
+static u64 alloc_raw(struct alloc_rec *r, int mode, size_t size)
+{
+    void *ptr = NULL;
+    struct page *pg = NULL;
+    int order;
+    size_t allocate_size = size;
+    u64 t0 = ktime_get_ns();
+    u64 latency;
+
+    switch (mode) {
+    case MODE_KMALLOC:
+        ptr = kmalloc(allocate_size, GFP_KERNEL);
+        break;
+    case MODE_VMALLOC:
+        ptr = vmalloc(allocate_size);
+        break;
+    case MODE_ALLOC_PAGES:
+        order = get_order(allocate_size);
+        pg = alloc_pages(GFP_KERNEL | __GFP_NOWARN, order);
+        if (pg)
+            ptr = page_address(pg);
+        break;
+    case MODE_COMPOUND:
+        /* 不足 PMD 的请求也分配一个完整的 PMD 大小复合页 */
+        order = max(get_order(allocate_size), HUGE_ORDER);
+        allocate_size = PAGE_SIZE << order;
+        pg = alloc_pages(GFP_KERNEL | __GFP_COMP | __GFP_NOWARN, order);
+        if (pg)
+            ptr = page_address(pg);
+        break;
+#ifdef HAVE_VMALLOC_HUGE
+    case MODE_VMALLOC_HUGE:
+        ptr = vmalloc_huge(allocate_size, GFP_KERNEL);
+        break;
+#endif
+#ifdef HAVE_CONTIG_ALLOC
+    case MODE_CONTIG:
+        pg = alloc_contig_pages(PAGE_ALIGN(allocate_size) >> PAGE_SHIFT,
+                                GFP_KERNEL | __GFP_NOWARN, numa_node_id(), NULL);
+        if (pg)
+            ptr = page_address(pg);
+        break;
+#endif
+    default:
+        break;
+    }
+    latency = ktime_get_ns() - t0;
+
+    r->ptr = ptr;
+    r->page = pg;
+    r->size = allocate_size;
+    r->mode = mode;
+    if (ptr)
+        trace_alloc_demo_alloc(mode, allocate_size, ptr, alloc_node(mode, ptr, pg), latency);
+    else
+        trace_alloc_demo_alloc(mode, allocate_size, NULL, NUMA_NO_NODE, latency);
+    return latency;
+}
+
+/* sysfs 与缓存路径：分配后更新该模式的累计统计 */
+static u64 alloc_record(struct alloc_rec *r, int mode, size_t size)
+{
+    u64 latency = alloc_raw(r, mode, size);
+
+    account_alloc(mode, r->ptr, r->size, latency);
+    return latency;
 }
 
 /* Called from sysfs action=alloc */
@@ -108,54 +454,393 @@ static void do_allocs(int mode, size_t size, int count)
     }
 
     for (i = 0; i < count; i++) {
-        void *ptr = NULL;
-        struct page *pg = NULL;
-        int order;
-        size_t allocate_size = size;
-
-        switch (mode) {
-        case MODE_KMALLOC:
-            ptr = kmalloc(allocate_size, GFP_KERNEL);
-            break;
-        case MODE_VMALLOC:
-            ptr = vmalloc(allocate_size);
-            break;
-        case MODE_ALLOC_PAGES:
-            order = get_order(allocate_size);
-            pg = alloc_pages(GFP_KERNEL, order);
-            if (pg)
-                ptr = page_address(pg);
-            break;
-        default:
-            break;
-        }
+        struct alloc_rec *r = &state.recs[state.alloc_used];
 
-        if (ptr) {
-            struct alloc_rec *r = &state.recs[state.alloc_used++];
-            r->ptr = ptr;
-            r->page = pg;
-            r->size = allocate_size;
-            r->mode = mode;
+        alloc_record(r, mode, size);
+        if (r->ptr) {
+            state.alloc_used++;
             state.success_count++;
         } else {
             state.fail_count++;
-            pr_warn("alloc_demo: allocation failed mode=%d size=%zu idx=%d\n", mode, allocate_size, i);
         }
     }
 
     mutex_unlock(&state.lock);
 }
 
-/* Free all stored allocations */
-static void free_all_allocs(void)
+static void replay_hist_add(unsigned long *hist, u64 ns)
+{
+    hist[min_t(int, ns ? ilog2(ns) : 0, REPLAY_HIST - 1)]++;
+}
+
+/* 从 log2 直方图估算百分位，返回所在桶的上界 (ns) */
+static u64 replay_hist_pct(const unsigned long *hist, unsigned long total, unsigned int pct)
+{
+    unsigned long want = div_u64((u64)total * pct + 99, 100), acc = 0;
+    int b;
+
+    for (b = 0; b < REPLAY_HIST; b++) {
+        acc += hist[b];
+        if (acc >= want && acc)
+            return 2ULL << b;
+    }
+    return 0;
+}
+
+/* 校验整个 trace，返回最大 id；执行期间不再检查格式 */
+static int replay_validate(const struct replay_op *ops, size_t nr, u32 *max_id)
+{
+    size_t i;
+
+    *max_id = 0;
+    for (i = 0; i < nr; i++) {
+        const struct replay_op *op = &ops[i];
+
+        if (op->id >= REPLAY_MAX_ID)
+            return -EINVAL;
+        if (op->op == REPLAY_OP_ALLOC) {
+            if (op->mode >= MODE_NR || !op->size || op->size > SIZE_MAX)
+                return -EINVAL;
+            if (!mode_supported(op->mode))
+                return -EOPNOTSUPP;
+            if (op->mode == MODE_KMALLOC && op->size > KMALLOC_MAX_SIZE)
+                return -EINVAL;
+            if ((op->mode == MODE_ALLOC_PAGES || op->mode == MODE_COMPOUND) &&
+                get_order(op->size) > ALLOC_DEMO_MAX_ORDER)
+                return -EINVAL;
+        } else if (op->op != REPLAY_OP_FREE) {
+            return -EINVAL;
+        }
+        *max_id = max(*max_id, op->id);
+    }
+    return 0;
+}
+
+/* 在内核中按顺序执行已上传的 trace，结果写入 replay_res。调用者持有 state.lock */
+static int run_replay(void)
+{
+    const struct replay_op *ops = replay_buf;
+    size_t nr = replay_len / sizeof(*ops), i;
+    struct replay_result *res = &replay_res;
+    struct alloc_rec *objs;
+    u32 max_id;
+    u64 t0, lat;
+    int ret;
+
+    memset(res, 0, sizeof(*res));
+    if (!nr || replay_len % sizeof(*ops)) {
+        ret = -EINVAL;
+        goto out;
+    }
+    ret = replay_validate(ops, nr, &max_id);
+    if (ret)
+        goto out;
+
+    /* 按 id 直接索引存活对象 */
+    objs = kvcalloc(max_id + 1, sizeof(*objs), GFP_KERNEL);
+    if (!objs) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    t0 = ktime_get_ns();
+    for (i = 0; i < nr; i++) {
+        const struct replay_op *op = &ops[i];
+        struct alloc_rec *r = &objs[op->id];
+
+        if (op->op == REPLAY_OP_ALLOC) {
+            if (r->ptr) {
+                res->bad_ops++;
+                continue;
+            }
+            /* 不走 account_alloc：回放结果只进 replay_res，不混入交互模式的统计 */
+            lat = alloc_raw(r, op->mode, op->size);
+            res->allocs++;
+            res->alloc_ns += lat;
+            res->alloc_max_ns = max(res->alloc_max_ns, lat);
+            replay_hist_add(res->alloc_hist, lat);
+            if (!r->ptr) {
+                res->fails++;
+                continue;
+            }
+            res->cur_bytes += r->size;
+            res->cur_objs++;
+            res->peak_bytes = max(res->peak_bytes, res->cur_bytes);
+            res->peak_objs = max(res->peak_objs, res->cur_objs);
+        } else {
+            if (!r->ptr) {
+                res->bad_ops++;
+                continue;
+            }
+            res->cur_bytes -= r->size;
+            res->cur_objs--;
+            lat = free_record(r);
+            res->frees++;
+            res->free_ns += lat;
+            res->free_max_ns = max(res->free_max_ns, lat);
+            replay_hist_add(res->free_hist, lat);
+        }
+        if ((i & 1023) == 1023)
+            cond_resched();
+    }
+    res->elapsed_ns = ktime_get_ns() - t0;
+    res->ops = nr;
+
+    for (i = 0; i <= max_id; i++) {
+        if (objs[i].ptr) {
+            res->leaked++;
+            free_record(&objs[i]);
+        }
+    }
+    kvfree(objs);
+out:
+    res->ret = ret;
+    return ret;
+}
+
+/* Free all stored allocations; fails with -EBUSY while any record is mmapped */
+static int free_all_allocs(void)
 {
     int i;
     mutex_lock(&state.lock);
+    if (atomic_read(&nr_mmaps)) {
+        mutex_unlock(&state.lock);
+        return -EBUSY;
+    }
     for (i = 0; i < state.alloc_used; i++) {
         free_record(&state.recs[i]);
     }
     state.alloc_used = 0;
     mutex_unlock(&state.lock);
+    return 0;
+}
+
+/* 90% 的访问落在前 10% 的 key 上，模拟有热点的缓存 */
+static u32 cache_pick_key(void)
+{
+    u32 r = get_random_u32();
+    u32 hot = max(cache_keys / 10, 1U);
+
+    return (r % 10) ? (r >> 4) % hot : (r >> 4) % cache_keys;
+}
+
+static struct cache_obj *cache_find(u32 key)
+{
+    struct cache_obj *obj;
+
+    hash_for_each_possible(cache_hash, obj, node, key) {
+        if (obj->key == key)
+            return obj;
+    }
+    return NULL;
+}
+
+/* 摘下对象，调用者持有 cache_lock */
+static void cache_unlink(struct cache_obj *obj, struct list_head *victims)
+{
+    list_move(&obj->lru, victims);
+    hash_del(&obj->node);
+    cache_nr--;
+    cache_bytes -= obj->rec.size;
+}
+
+static void cache_free_list(struct list_head *victims)
+{
+    struct cache_obj *obj, *tmp;
+
+    list_for_each_entry_safe(obj, tmp, victims, lru) {
+        free_record(&obj->rec);
+        kfree(obj);
+    }
+}
+
+/* Called from sysfs action=cache_access */
+static void cache_access(int mode, size_t size, int count)
+{
+    int i;
+
+    mutex_lock(&state.lock);
+    for (i = 0; i < count; i++) {
+        u32 key = cache_pick_key();
+        struct cache_obj *obj;
+        u64 t0, lat;
+
+        if ((i & 255) == 255)
+            cond_resched();
+
+        t0 = ktime_get_ns();
+        spin_lock(&cache_lock);
+        cache_stats.lookups++;
+        obj = cache_find(key);
+        if (obj) {
+            cache_stats.hits++;
+            list_move(&obj->lru, &cache_lru);
+            spin_unlock(&cache_lock);
+            continue;
+        }
+        cache_stats.misses++;
+        spin_unlock(&cache_lock);
+
+        /* 未命中：锁外分配并填充，可能触发直接回收并进入本模块的 shrinker */
+        obj = kzalloc(sizeof(*obj), GFP_KERNEL);
+        if (obj)
+            alloc_record(&obj->rec, mode, size);
+        if (!obj || !obj->rec.ptr) {
+            kfree(obj);
+            spin_lock(&cache_lock);
+            cache_stats.fill_fails++;
+            spin_unlock(&cache_lock);
+            continue;
+        }
+        obj->key = key;
+        memset(obj->rec.ptr, key & 0xff, obj->rec.size);
+        lat = ktime_get_ns() - t0;
+
+        /* state.lock 下只有一个访问者，key 不会被并发插入 */
+        spin_lock(&cache_lock);
+        hash_add(cache_hash, &obj->node, key);
+        list_add(&obj->lru, &cache_lru);
+        cache_nr++;
+        cache_bytes += obj->rec.size;
+        cache_stats.miss_ns += lat;
+        cache_stats.miss_max_ns = max(cache_stats.miss_max_ns, lat);
+        replay_hist_add(cache_stats.miss_hist, lat);
+        spin_unlock(&cache_lock);
+    }
+    mutex_unlock(&state.lock);
+}
+
+/* Called from sysfs action=cache_drop and module exit */
+static void cache_drop(void)
+{
+    LIST_HEAD(victims);
+    unsigned long nr;
+
+    spin_lock(&cache_lock);
+    nr = cache_nr;
+    while (!list_empty(&cache_lru))
+        cache_unlink(list_first_entry(&cache_lru, struct cache_obj, lru), &victims);
+    cache_stats.dropped += nr;
+    spin_unlock(&cache_lock);
+
+    cache_free_list(&victims);
+}
+
+static unsigned long cache_count_objects(struct shrinker *shrink, struct shrink_control *sc)
+{
+    unsigned long nr = READ_ONCE(cache_nr);
+
+    atomic_long_inc(&cache_count_calls);
+    return nr ? nr : SHRINK_EMPTY;
+}
+
+/* 从 LRU 尾部回收最多 nr_to_scan 个对象，释放在锁外进行 */
+static unsigned long cache_scan_objects(struct shrinker *shrink, struct shrink_control *sc)
+{
+    LIST_HEAD(victims);
+    unsigned long freed = 0;
+    u64 t0 = ktime_get_ns(), lat;
+
+    spin_lock(&cache_lock);
+    while (freed < sc->nr_to_scan && !list_empty(&cache_lru)) {
+        cache_unlink(list_last_entry(&cache_lru, struct cache_obj, lru), &victims);
+        freed++;
+    }
+    spin_unlock(&cache_lock);
+
+    cache_free_list(&victims);
+    lat = ktime_get_ns() - t0;
+    trace_alloc_demo_shrink(sc->nr_to_scan, freed, lat);
+
+    spin_lock(&cache_lock);
+    cache_stats.reclaimed += freed;
+    cache_stats.scan_calls++;
+    cache_stats.scan_requested += sc->nr_to_scan;
+    cache_stats.scan_ns += lat;
+    cache_stats.scan_max_ns = max(cache_stats.scan_max_ns, lat);
+    replay_hist_add(cache_stats.scan_hist, lat);
+    spin_unlock(&cache_lock);
+
+    return freed ? freed : SHRINK_STOP;
+}
+
+/* shrinker 注册接口：6.0 起带名字，6.7 起改为 shrinker_alloc/shrinker_register */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6,7,0)
+static struct shrinker cache_shrinker_static = {
+    .count_objects = cache_count_objects,
+    .scan_objects  = cache_scan_objects,
+    .seeks         = DEFAULT_SEEKS,
+};
+#endif
+
+static int cache_shrinker_register(void)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,7,0)
+    cache_shrinker = shrinker_alloc(0, "alloc_demo-cache");
+    if (!cache_shrinker)
+        return -ENOMEM;
+    cache_shrinker->count_objects = cache_count_objects;
+    cache_shrinker->scan_objects = cache_scan_objects;
+    cache_shrinker->seeks = DEFAULT_SEEKS;
+    shrinker_register(cache_shrinker);
+    return 0;
+#else
+    int ret;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,0,0)
+    ret = register_shrinker(&cache_shrinker_static, "alloc_demo-cache");
+#else
+    ret = register_shrinker(&cache_shrinker_static);
+#endif
+    if (!ret)
+        cache_shrinker = &cache_shrinker_static;
+    return ret;
+#endif
+}
+
+static void cache_shrinker_unregister(void)
+{
+    if (!cache_shrinker)
+        return;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,7,0)
+    shrinker_free(cache_shrinker);
+#else
+    unregister_shrinker(cache_shrinker);
+#endif
+    cache_shrinker = NULL;
+}
+
+static void cache_show(struct seq_file *m)
+{
+    struct cache_stats st;
+    unsigned long nr, filled;
+    size_t bytes;
+
+    /* 先拷贝快照，seq_printf 不在自旋锁内进行 */
+    spin_lock(&cache_lock);
+    st = cache_stats;
+    nr = cache_nr;
+    bytes = cache_bytes;
+    spin_unlock(&cache_lock);
+
+    seq_printf(m, "\ncache (keys: %u, shrinker: %s):\n", cache_keys,
+               cache_shrinker ? "registered" : "unregistered");
+    seq_printf(m, "  objs: %lu bytes: %zu\n", nr, bytes);
+    seq_printf(m, "  lookups: %lu hits: %lu misses: %lu fill_fails: %lu hit%%: %lu\n",
+               st.lookups, st.hits, st.misses, st.fill_fails,
+               st.lookups ? st.hits * 100 / st.lookups : 0);
+    filled = st.misses - st.fill_fails;
+    seq_printf(m, "  miss_ns: total %llu avg %llu p50 <%llu p99 <%llu max %llu\n", st.miss_ns,
+               filled ? div64_u64(st.miss_ns, filled) : 0,
+               replay_hist_pct(st.miss_hist, filled, 50),
+               replay_hist_pct(st.miss_hist, filled, 99), st.miss_max_ns);
+    seq_printf(m, "  reclaimed: %lu dropped: %lu count_calls: %lu scan_calls: %lu scan_requested: %lu\n",
+               st.reclaimed, st.dropped, atomic_long_read(&cache_count_calls),
+               st.scan_calls, st.scan_requested);
+    seq_printf(m, "  scan_ns: total %llu avg %llu p50 <%llu p99 <%llu max %llu\n", st.scan_ns,
+               st.scan_calls ? div64_u64(st.scan_ns, st.scan_calls) : 0,
+               replay_hist_pct(st.scan_hist, st.scan_calls, 50),
+               replay_hist_pct(st.scan_hist, st.scan_calls, 99), st.scan_max_ns);
 }
 
 /* ---------- procfs output ---------- */
@@ -165,9 +850,7 @@ static int proc_show(struct seq_file *m, void *v)
     int i;
     seq_printf(m, "alloc_demo module stats\n");
     seq_printf(m, "=======================\n");
-    seq_printf(m, "mode (current): %s (%d)\n",
-               (cur_mode >= 0 && cur_mode <= MODE_VMALLOC) ? mode_names[cur_mode] : "unknown",
-               cur_mode);
+    seq_printf(m, "mode (current): %s (%d)\n", mode_name(cur_mode), cur_mode);
     seq_printf(m, "size (current): %zu\n", cur_size);
     seq_printf(m, "count (current): %d\n", cur_count);
 
@@ -176,13 +859,54 @@ static int proc_show(struct seq_file *m, void *v)
     seq_printf(m, "active_allocs: %d\n", state.alloc_used);
     seq_printf(m, "success_count: %lu\n", state.success_count);
     seq_printf(m, "fail_count: %lu\n", state.fail_count);
+    seq_printf(m, "user_mappings: %d\n", atomic_read(&nr_mmaps));
+
+    /* 每种模式的成功率、延迟与 PMD 对齐物理连续块的数量（由物理布局推断，不读页表） */
+    seq_printf(m, "\nper-mode stats:\n");
+    seq_printf(m, "  %-12s %8s %8s %7s %12s %12s %12s %16s %11s\n", "mode", "ok", "fail",
+               "ok%", "avg_ns", "min_ns", "max_ns", "pmd_aligned_runs", "other_pages");
+    for (i = 0; i < MODE_NR; i++) {
+        struct mode_stats *st = &state.stats[i];
+        unsigned long total = st->ok + st->fail;
+
+        if (!mode_supported(i)) {
+            seq_printf(m, "  %-12s (not available in this build)\n", mode_names[i]);
+            continue;
+        }
+        seq_printf(m, "  %-12s %8lu %8lu %7lu %12llu %12llu %12llu %16lu %11lu\n", mode_names[i],
+                   st->ok, st->fail, total ? st->ok * 100 / total : 0,
+                   st->ok ? div64_u64(st->lat_sum_ns, st->ok) : 0,
+                   st->lat_min_ns, st->lat_max_ns, st->pmd_aligned_runs, st->other_pages);
+    }
+    if (replay_res.ops || replay_res.ret) {
+        struct replay_result *res = &replay_res;
+
+        seq_printf(m, "\nreplay (last run, %zu bytes loaded):\n", replay_len);
+        if (res->ret) {
+            seq_printf(m, "  error: %d\n", res->ret);
+        } else {
+            seq_printf(m, "  ops: %lu allocs: %lu frees: %lu fails: %lu bad_ops: %lu leaked: %lu\n",
+                       res->ops, res->allocs, res->frees, res->fails, res->bad_ops, res->leaked);
+            seq_printf(m, "  elapsed_ns: %llu throughput_ops_per_s: %llu\n", res->elapsed_ns,
+                       res->elapsed_ns ? div64_u64((u64)res->ops * NSEC_PER_SEC, res->elapsed_ns) : 0);
+            seq_printf(m, "  alloc_ns: avg %llu p50 <%llu p99 <%llu max %llu\n",
+                       res->allocs ? div64_u64(res->alloc_ns, res->allocs) : 0,
+                       replay_hist_pct(res->alloc_hist, res->allocs, 50),
+                       replay_hist_pct(res->alloc_hist, res->allocs, 99), res->alloc_max_ns);
+            seq_printf(m, "  free_ns: avg %llu p50 <%llu p99 <%llu max %llu\n",
+                       res->frees ? div64_u64(res->free_ns, res->frees) : 0,
+                       replay_hist_pct(res->free_hist, res->frees, 50),
+                       replay_hist_pct(res->free_hist, res->frees, 99), res->free_max_ns);
+            seq_printf(m, "  peak_bytes: %zu peak_objs: %lu\n", res->peak_bytes, res->peak_objs);
+        }
+    }
+    cache_show(m);
+
     seq_printf(m, "\nactive allocation records:\n");
     for (i = 0; i < state.alloc_used; i++) {
         struct alloc_rec *r = &state.recs[i];
         seq_printf(m, "  [%2d] mode=%s size=%6zu ptr=%p page=%p\n",
-                   i,
-                   (r->mode >= 0 && r->mode <= MODE_VMALLOC) ? mode_names[r->mode] : "unknown",
-                   r->size, r->ptr, r->page);
+                   i, mode_name(r->mode), r->size, r->ptr, r->page);
     }
     mutex_unlock(&state.lock);
     seq_printf(m, "---- end ----\n");
@@ -221,16 +945,23 @@ static ssize_t mode_show(struct kobject *kobj, struct kobj_attribute *attr, char
 
 static ssize_t mode_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
 {
-    if (sysfs_streq(buf, "kmalloc") || sysfs_streq(buf, "0")) {
-        cur_mode = MODE_KMALLOC;
-    } else if (sysfs_streq(buf, "alloc_pages") || sysfs_streq(buf, "1")) {
-        cur_mode = MODE_ALLOC_PAGES;
-    } else if (sysfs_streq(buf, "vmalloc") || sysfs_streq(buf, "2")) {
-        cur_mode = MODE_VMALLOC;
-    } else {
+    int mode;
+
+    /* 接受模式名或编号 */
+    for (mode = 0; mode < MODE_NR; mode++) {
+        if (sysfs_streq(buf, mode_names[mode]))
+            break;
+    }
+    if (mode == MODE_NR && kstrtoint(buf, 0, &mode))
+        mode = -1;
+
+    if (mode < 0 || mode >= MODE_NR) {
         pr_warn("alloc_demo: unknown mode write: %.*s\n", (int)min(count, (size_t)64), buf);
         return -EINVAL;
     }
+    if (!mode_supported(mode))
+        return -EOPNOTSUPP;
+    cur_mode = mode;
     return count;
 }
 
@@ -242,7 +973,7 @@ static ssize_t size_show(struct kobject *kobj, struct kobj_attribute *attr, char
 static ssize_t size_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
 {
     unsigned long val;
-    if (kstrtoul(buf, 0, &val))
+    if (kstrtoul(buf, 0, &val) || !val)
         return -EINVAL;
     cur_size = (size_t)val;
     return count;
@@ -266,17 +997,50 @@ static ssize_t count_store(struct kobject *kobj, struct kobj_attribute *attr, co
 
 static ssize_t action_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
 {
+    int ret = 0;
+
     if (sysfs_streq(buf, "alloc")) {
         do_allocs(cur_mode, cur_size, cur_count);
     } else if (sysfs_streq(buf, "free")) {
-        free_all_allocs();
+        ret = free_all_allocs();
     } else if (sysfs_streq(buf, "alloc_and_free")) {
         do_allocs(cur_mode, cur_size, cur_count);
-        free_all_allocs();
+        ret = free_all_allocs();
+    } else if (sysfs_streq(buf, "replay")) {
+        mutex_lock(&state.lock);
+        ret = run_replay();
+        mutex_unlock(&state.lock);
+    } else if (sysfs_streq(buf, "cache_access")) {
+        cache_access(cur_mode, cur_size, cur_count);
+    } else if (sysfs_streq(buf, "cache_drop")) {
+        cache_drop();
+    } else if (sysfs_streq(buf, "reset_stats")) {
+        mutex_lock(&state.lock);
+        memset(state.stats, 0, sizeof(state.stats));
+        mutex_unlock(&state.lock);
+        spin_lock(&cache_lock);
+        memset(&cache_stats, 0, sizeof(cache_stats));
+        spin_unlock(&cache_lock);
+        atomic_long_set(&cache_count_calls, 0);
     } else {
         pr_warn("alloc_demo: unknown action '%.*s'\n", (int)min(count, (size_t)64), buf);
         return -EINVAL;
     }
+    return ret ? ret : count;
+}
+
+static ssize_t cache_keys_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", cache_keys);
+}
+
+/* 缩小 key 空间不会淘汰已有对象，它们只是不再被访问，最终由 shrinker 回收 */
+static ssize_t cache_keys_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+{
+    unsigned int val;
+    if (kstrtouint(buf, 0, &val) || !val || val > CACHE_MAX_KEYS)
+        return -EINVAL;
+    cache_keys = val;
     return count;
 }
 
@@ -284,19 +1048,209 @@ static struct kobj_attribute mode_attr = __ATTR(mode, 0664, mode_show, mode_stor
 static struct kobj_attribute size_attr = __ATTR(size, 0664, size_show, size_store);
 static struct kobj_attribute count_attr = __ATTR(count, 0664, count_show, count_store);
 static struct kobj_attribute action_attr = __ATTR_WO(action);
+static struct kobj_attribute cache_keys_attr = __ATTR(cache_keys, 0664, cache_keys_show, cache_keys_store);
+
+/* 写入二进制 trace：从 offset 0 写入即替换旧 trace，之后必须顺序追加 */
+static ssize_t replay_write(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
+                            char *buf, loff_t off, size_t count)
+{
+    ssize_t ret = count;
+
+    mutex_lock(&state.lock);
+    if (off == 0)
+        replay_len = 0;
+    if (off != replay_len) {
+        ret = -EINVAL;
+        goto out;
+    }
+    if (replay_len + count > REPLAY_MAX_BYTES) {
+        ret = -EFBIG;
+        goto out;
+    }
+    if (replay_len + count > replay_cap) {
+        size_t cap = min_t(size_t, max_t(size_t, replay_cap * 2, PAGE_ALIGN(replay_len + count)),
+                           REPLAY_MAX_BYTES);
+        void *nbuf = kvmalloc(cap, GFP_KERNEL);
+
+        if (!nbuf) {
+            ret = -ENOMEM;
+            goto out;
+        }
+        if (replay_len)
+            memcpy(nbuf, replay_buf, replay_len);
+        kvfree(replay_buf);
+        replay_buf = nbuf;
+        replay_cap = cap;
+    }
+    memcpy(replay_buf + replay_len, buf, count);
+    replay_len += count;
+out:
+    mutex_unlock(&state.lock);
+    return ret;
+}
+
+static BIN_ATTR_WO(replay, 0);
+
+static struct bin_attribute *alloc_bin_attrs[] = {
+    &bin_attr_replay,
+    NULL,
+};
 
 static struct attribute *alloc_attrs[] = {
     &mode_attr.attr,
     &size_attr.attr,
     &count_attr.attr,
     &action_attr.attr,
+    &cache_keys_attr.attr,
     NULL,
 };
 
 static struct attribute_group alloc_attr_group = {
     .attrs = alloc_attrs,
+    .bin_attrs = alloc_bin_attrs,
+};
+
+/* ---------- mmap device ---------- */
+
+static void alloc_vm_open(struct vm_area_struct *vma)
+{
+    atomic_inc(&nr_mmaps);
+}
+
+static void alloc_vm_close(struct vm_area_struct *vma)
+{
+    atomic_dec(&nr_mmaps);
+}
+
+static const struct vm_operations_struct alloc_vm_ops = {
+    .open  = alloc_vm_open,
+    .close = alloc_vm_close,
+};
+
+/*
+ * vmalloc 区逐页 vm_insert_page。remap_vmalloc_range() 要求区域带 VM_USERMAP
+ * （只有 vmalloc_user() 会设置），而这里的 vmalloc 记录来自普通 vmalloc()，
+ * 故按其实现逐页插入；页带引用计数，映射期间不会被真正释放。
+ */
+static int map_vmalloc(struct vm_area_struct *vma, void *ptr, unsigned long len)
+{
+    unsigned long off;
+    int ret;
+
+    for (off = 0; off < len; off += PAGE_SIZE) {
+        ret = vm_insert_page(vma, vma->vm_start + off, vmalloc_to_page(ptr + off));
+        if (ret)
+            return ret;
+    }
+    return 0;
+}
+
+/* mmap offset 选择记录：offset = 记录下标 * PAGE_SIZE，长度不超过记录大小（按页取整） */
+static int alloc_dev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    unsigned long len = vma->vm_end - vma->vm_start;
+    unsigned long idx = vma->vm_pgoff;
+    struct alloc_rec *r;
+    unsigned long pfn;
+    int ret;
+
+    /* MAP_PRIVATE 的 COW 映射会改写 vm_pgoff，只支持共享映射 */
+    if (!(vma->vm_flags & VM_SHARED))
+        return -EINVAL;
+
+    mutex_lock(&state.lock);
+    if (idx >= state.alloc_used || !state.recs[idx].ptr) {
+        ret = -ENXIO;
+        goto out;
+    }
+    r = &state.recs[idx];
+    if (len > PAGE_ALIGN(r->size)) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    switch (r->mode) {
+    case MODE_KMALLOC:
+        /* 只映射整页对齐且独占整页的对象，避免把同页的其它 slab 对象暴露给用户 */
+        if (!PAGE_ALIGNED(r->ptr) || ksize(r->ptr) < PAGE_ALIGN(r->size)) {
+            ret = -EINVAL;
+            goto out;
+        }
+        pfn = virt_to_phys(r->ptr) >> PAGE_SHIFT;
+        ret = remap_pfn_range(vma, vma->vm_start, pfn, len, vma->vm_page_prot);
+        break;
+    case MODE_ALLOC_PAGES:
+    case MODE_COMPOUND:
+    case MODE_CONTIG:
+        ret = remap_pfn_range(vma, vma->vm_start, page_to_pfn(r->page), len, vma->vm_page_prot);
+        break;
+    case MODE_VMALLOC:
+    case MODE_VMALLOC_HUGE:
+        ret = map_vmalloc(vma, r->ptr, len);
+        break;
+    default:
+        ret = -EINVAL;
+        break;
+    }
+    if (ret)
+        goto out;
+
+    vma->vm_ops = &alloc_vm_ops;
+    alloc_vm_open(vma);
+out:
+    mutex_unlock(&state.lock);
+    return ret;
+}
+
+static const struct file_operations alloc_dev_fops = {
+    .owner = THIS_MODULE,
+    .mmap  = alloc_dev_mmap,
 };
 
+static int alloc_dev_create(void)
+{
+    struct device *dev;
+    int ret;
+
+    ret = alloc_chrdev_region(&alloc_devt, 0, 1, DEVICE_NAME);
+    if (ret)
+        return ret;
+
+    cdev_init(&alloc_cdev, &alloc_dev_fops);
+    ret = cdev_add(&alloc_cdev, alloc_devt, 1);
+    if (ret)
+        goto err_region;
+
+    alloc_class = class_create(THIS_MODULE, CLASS_NAME);
+    if (IS_ERR(alloc_class)) {
+        ret = PTR_ERR(alloc_class);
+        goto err_cdev;
+    }
+
+    dev = device_create(alloc_class, NULL, alloc_devt, NULL, DEVICE_NAME);
+    if (IS_ERR(dev)) {
+        ret = PTR_ERR(dev);
+        goto err_class;
+    }
+    return 0;
+
+err_class:
+    class_destroy(alloc_class);
+err_cdev:
+    cdev_del(&alloc_cdev);
+err_region:
+    unregister_chrdev_region(alloc_devt, 1);
+    return ret;
+}
+
+static void alloc_dev_destroy(void)
+{
+    device_destroy(alloc_class, alloc_devt);
+    class_destroy(alloc_class);
+    cdev_del(&alloc_cdev);
+    unregister_chrdev_region(alloc_devt, 1);
+}
+
 /* ---------- module init / exit ---------- */
 
 static int __init alloc_demo_init(void)
@@ -328,15 +1282,29 @@ static int __init alloc_demo_init(void)
 
     if (!proc_create(PROC_NAME, 0444, NULL, &proc_fops)) {
         pr_err("alloc_demo: proc_create failed\n");
-        sysfs_remove_group(alloc_kobj, &alloc_attr_group);
-        kobject_put(alloc_kobj);
         ret = -ENOMEM;
-        goto out_free;
+        goto out_sysfs;
     }
 
-    pr_info("alloc_demo: sysfs at /sys/kernel/alloc_demo, proc at /proc/%s\n", PROC_NAME);
+    ret = alloc_dev_create();
+    if (ret) {
+        pr_err("alloc_demo: failed to create /dev/%s: %d\n", DEVICE_NAME, ret);
+        remove_proc_entry(PROC_NAME, NULL);
+        goto out_sysfs;
+    }
+
+    /* 注册失败不影响其它功能，缓存对象只是不会被自动回收 */
+    ret = cache_shrinker_register();
+    if (ret)
+        pr_warn("alloc_demo: failed to register cache shrinker: %d\n", ret);
+
+    pr_info("alloc_demo: sysfs at /sys/kernel/alloc_demo, proc at /proc/%s, mmap via /dev/%s\n",
+            PROC_NAME, DEVICE_NAME);
     return 0;
 
+out_sysfs:
+    sysfs_remove_group(alloc_kobj, &alloc_attr_group);
+    kobject_put(alloc_kobj);
 out_free:
     kfree(state.recs);
     return ret;
@@ -345,13 +1313,18 @@ out_free:
 static void __exit alloc_demo_exit(void)
 {
     pr_info("alloc_demo: exit - freeing all\n");
+    /* 打开的 /dev/alloc_demo（含其映射）持有模块引用，到这里已没有用户映射 */
+    alloc_dev_destroy();
     free_all_allocs();
+    cache_shrinker_unregister();
+    cache_drop();
 
     remove_proc_entry(PROC_NAME, NULL);
     sysfs_remove_group(alloc_kobj, &alloc_attr_group);
     kobject_put(alloc_kobj);
 
     kfree(state.recs);
+    kvfree(replay_buf);
     pr_info("alloc_demo: module unloaded\n");
 }
 
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* alloc_demo_trace.h: alloc_demo 的 tracepoint 定义，替代热路径上的 printk */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM alloc_demo
+
+#if !defined(_ALLOC_DEMO_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _ALLOC_DEMO_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/* 与 alloc_demo.c 中 enum alloc_mode 一致 */
+#define show_alloc_mode(mode) __print_symbolic(mode,    \
+    { 0, "kmalloc" },                                   \
+    { 1, "alloc_pages" },                               \
+    { 2, "vmalloc" },                                   \
+    { 3, "compound" },                                  \
+    { 4, "vmalloc_huge" },                              \
+    { 5, "contig" })
+
+DECLARE_EVENT_CLASS(alloc_demo_op,
+
+    TP_PROTO(int mode, size_t size, const void *ptr, int node, u64 latency_ns),
+
+    TP_ARGS(mode, size, ptr, node, latency_ns),
+
+    TP_STRUCT__entry(
+        __field(int,            mode)
+        __field(size_t,         size)
+        __field(const void *,   ptr)
+        __field(int,            node)
+        __field(u64,            latency_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->mode       = mode;
+        __entry->size       = size;
+        __entry->ptr        = ptr;
+        __entry->node       = node;
+        __entry->latency_ns = latency_ns;
+    ),
+
+    TP_printk("mode=%s size=%zu ptr=%p node=%d latency_ns=%llu",
+              show_alloc_mode(__entry->mode), __entry->size, __entry->ptr,
+              __entry->node, __entry->latency_ns)
+);
+
+/* 一次分配：ptr 为 NULL 表示失败，此时 node 为 NUMA_NO_NODE */
+DEFINE_EVENT(alloc_demo_op, alloc_demo_alloc,
+    TP_PROTO(int mode, size_t size, const void *ptr, int node, u64 latency_ns),
+    TP_ARGS(mode, size, ptr, node, latency_ns)
+);
+
+DEFINE_EVENT(alloc_demo_op, alloc_demo_free,
+    TP_PROTO(int mode, size_t size, const void *ptr, int node, u64 latency_ns),
+    TP_ARGS(mode, size, ptr, node, latency_ns)
+);
+
+/* 缓存 shrinker 的一次 scan_objects 回调 */
+TRACE_EVENT(alloc_demo_shrink,
+
+    TP_PROTO(unsigned long nr_to_scan, unsigned long freed, u64 latency_ns),
+
+    TP_ARGS(nr_to_scan, freed, latency_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned long,  nr_to_scan)
+        __field(unsigned long,  freed)
+        __field(u64,            latency_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->nr_to_scan = nr_to_scan;
+        __entry->freed      = freed;
+        __entry->latency_ns = latency_ns;
+    ),
+
+    TP_printk("nr_to_scan=%lu freed=%lu latency_ns=%llu",
+              __entry->nr_to_scan, __entry->freed, __entry->latency_ns)
+);
+
+#endif /* _ALLOC_DEMO_TRACE_H */
+
+/* 头文件与模块源码同目录，Makefile 中需 -I$(src) */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE alloc_demo_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,252 @@
+// alloc_replay.c
+// Build: gcc -O2 -o alloc_replay alloc_replay.c
+// Purpose: build binary allocation traces for alloc_demo's in-kernel replay engine and run them.
+//
+//   alloc_replay text2bin < trace.txt > trace.bin     文本 trace 转二进制
+//   alloc_replay gen <nr_ops> <max_live> <mode|mix> [seed] > trace.bin   生成合成负载
+//   sudo alloc_replay run trace.bin                   上传、执行并打印结果
+//
+// 文本格式每行一条操作（# 开头为注释）：
+//   a <id> <size> <mode>      分配，mode 为名字（kmalloc/alloc_pages/vmalloc/...）或编号
+//   f <id>                    释放同 id 的对象
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SYSFS  "/sys/kernel/alloc_demo"
+#define PROC   "/proc/alloc_demo"
+
+/* 与 alloc_demo.c 中 struct replay_op 一致 */
+struct replay_op {
+    uint8_t op;
+    uint8_t mode;
+    uint16_t reserved;
+    uint32_t id;
+    uint64_t size;
+};
+
+#define REPLAY_OP_ALLOC 1
+#define REPLAY_OP_FREE  2
+
+static const char *mode_names[] = {
+    "kmalloc", "alloc_pages", "vmalloc", "compound", "vmalloc_huge", "contig",
+};
+#define NR_MODES (int)(sizeof(mode_names) / sizeof(mode_names[0]))
+
+static int parse_mode(const char *s)
+{
+    char *end;
+    long v;
+    int i;
+
+    for (i = 0; i < NR_MODES; i++) {
+        if (!strcmp(s, mode_names[i]))
+            return i;
+    }
+    v = strtol(s, &end, 0);
+    return (*end || v < 0 || v >= NR_MODES) ? -1 : (int)v;
+}
+
+static int emit(const struct replay_op *op)
+{
+    return fwrite(op, sizeof(*op), 1, stdout) == 1 ? 0 : -1;
+}
+
+static int text2bin(void)
+{
+    char line[256], mode[32], kind;
+    unsigned long long size;
+    unsigned int id;
+    unsigned long lineno = 0;
+
+    while (fgets(line, sizeof(line), stdin)) {
+        struct replay_op op;
+        int n;
+
+        lineno++;
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        memset(&op, 0, sizeof(op));
+        kind = 0;
+        n = sscanf(line, " %c %u %llu %31s", &kind, &id, &size, mode);
+        if (n <= 0)     /* 只有空白的行 */
+            continue;
+        if (kind == 'a' && n == 4) {
+            int m = parse_mode(mode);
+
+            if (m < 0) {
+                fprintf(stderr, "line %lu: unknown mode '%s'\n", lineno, mode);
+                return 1;
+            }
+            op.op = REPLAY_OP_ALLOC;
+            op.mode = m;
+            op.size = size;
+        } else if (kind == 'f' && n >= 2) {
+            op.op = REPLAY_OP_FREE;
+        } else {
+            fprintf(stderr, "line %lu: cannot parse: %s", lineno, line);
+            return 1;
+        }
+        op.id = id;
+        if (emit(&op))
+            return 1;
+    }
+    return 0;
+}
+
+/* 大小按 log2 均匀分布在 16 B .. 256 KiB，mix 模式下按大小选择分配方式 */
+static int gen(unsigned long nr_ops, unsigned int max_live, const char *mode_arg, unsigned int seed)
+{
+    int fixed_mode = strcmp(mode_arg, "mix") ? parse_mode(mode_arg) : -1;
+    uint32_t *live;
+    unsigned int nlive = 0, next_id = 0;
+    unsigned long i;
+    struct replay_op op;
+
+    if (strcmp(mode_arg, "mix") && fixed_mode < 0) {
+        fprintf(stderr, "unknown mode '%s'\n", mode_arg);
+        return 1;
+    }
+    live = calloc(max_live, sizeof(*live));
+    if (!live)
+        return 1;
+    srand(seed);
+
+    for (i = 0; i < nr_ops; i++) {
+        memset(&op, 0, sizeof(op));
+        /* 存活对象越多越倾向释放，稳定在 max_live/2 附近 */
+        if (nlive && (nlive == max_live || (unsigned int)rand() % max_live < nlive)) {
+            unsigned int k = (unsigned int)rand() % nlive;
+
+            op.op = REPLAY_OP_FREE;
+            op.id = live[k];
+            live[k] = live[--nlive];
+        } else {
+            op.op = REPLAY_OP_ALLOC;
+            op.id = next_id++;
+            op.size = 16ull << (rand() % 15);
+            op.size += (uint64_t)rand() % op.size;
+            if (fixed_mode >= 0)
+                op.mode = fixed_mode;
+            else
+                op.mode = op.size <= 8192 ? 0 : (op.size <= 65536 ? 1 : 2);
+            live[nlive++] = op.id;
+        }
+        if (emit(&op)) {
+            free(live);
+            return 1;
+        }
+    }
+    free(live);
+    return 0;
+}
+
+static int write_file(const char *path, const void *buf, size_t len)
+{
+    const char *p = buf;
+    int fd = open(path, O_WRONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    while (len) {
+        ssize_t n = write(fd, p, len);
+
+        if (n < 0) {
+            fprintf(stderr, "write %s: %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    close(fd);
+    return 0;
+}
+
+static int run(const char *trace)
+{
+    char *buf = NULL, line[256];
+    size_t len = 0, cap = 0;
+    int print = 0;
+    FILE *f;
+
+    f = fopen(trace, "rb");
+    if (!f) {
+        perror(trace);
+        return 1;
+    }
+    for (;;) {
+        size_t n;
+
+        if (len == cap) {
+            char *nbuf = realloc(buf, cap = cap ? cap * 2 : 1 << 20);
+
+            if (!nbuf) {
+                free(buf);
+                fclose(f);
+                return 1;
+            }
+            buf = nbuf;
+        }
+        n = fread(buf + len, 1, cap - len, f);
+        if (!n)
+            break;
+        len += n;
+    }
+    fclose(f);
+    if (!len || len % sizeof(struct replay_op)) {
+        fprintf(stderr, "%s: size %zu is not a multiple of %zu\n", trace, len, sizeof(struct replay_op));
+        free(buf);
+        return 1;
+    }
+
+    if (write_file(SYSFS "/replay", buf, len) || write_file(SYSFS "/action", "replay", 6)) {
+        free(buf);
+        return 1;
+    }
+    free(buf);
+
+    /* 打印 /proc/alloc_demo 中的回放结果段 */
+    f = fopen(PROC, "r");
+    if (!f) {
+        perror(PROC);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, "replay", 6))
+            print = 1;
+        else if (print && line[0] != ' ')
+            break;
+        if (print)
+            fputs(line, stdout);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s text2bin < trace.txt > trace.bin\n", prog);
+    fprintf(stderr, "       %s gen <nr_ops> <max_live> <mode|mix> [seed] > trace.bin\n", prog);
+    fprintf(stderr, "       sudo %s run <trace.bin>\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 2 && !strcmp(argv[1], "text2bin"))
+        return text2bin();
+    if ((argc == 5 || argc == 6) && !strcmp(argv[1], "gen") && atoi(argv[3]) > 0)
+        return gen(strtoul(argv[2], NULL, 0), atoi(argv[3]), argv[4],
+                   argc == 6 ? (unsigned int)atoi(argv[5]) : 1);
+    if (argc == 3 && !strcmp(argv[1], "run"))
+        return run(argv[2]);
+    usage(argv[0]);
+    return 1;
+}
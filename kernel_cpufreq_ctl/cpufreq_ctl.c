@@ -5,6 +5,14 @@
 #include <linux/device.h>
 #include <linux/uaccess.h>
 #include <linux/cpufreq.h>
+#include <linux/pm_qos.h>
+#include <linux/slab.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+
+#define CREATE_TRACE_POINTS
+#include "cpufreq_ctl_trace.h"
 
 #define DEVICE_NAME "cpufreq_ctl"
 #define CLASS_NAME  "cpufreq"
@@ -16,41 +24,274 @@ struct cpufreq_ioctl_data {
     unsigned int freq;
 };
 
+/*
+ * freq_qos 模式：每个打开的 fd 在 CPU 所属 policy 上持有自己的 min/max 请求，
+ * 由 cpufreq 核心与 governor、thermal 等其它请求一起聚合，而不是最后写者胜出。
+ * min = max = 0 撤销该 fd 在此 policy 上的请求；max = 0 表示不限上限。
+ * fd 关闭时自动撤销其全部请求。
+ *
+ * 请求不长期持有 policy 引用：引用会让 cpufreq_unregister_driver() 在
+ * cpufreq_policy_put_kobj() 中一直等到 fd 关闭（rmmod cpufreq_sim 挂住）。
+ * policy 被销毁时由 CPUFREQ_REMOVE_POLICY 通知撤销挂在它上面的请求。
+ */
+#define IOCTL_QOS_SET   _IOW('q', 2, struct cpufreq_qos_data)
+#define IOCTL_QOS_QUERY _IOWR('q', 3, struct cpufreq_qos_query)
+
+struct cpufreq_qos_data {
+    unsigned int cpu;
+    unsigned int min;
+    unsigned int max;
+};
+
+struct cpufreq_qos_query {
+    unsigned int cpu;           /* in */
+    unsigned int cur;           /* 当前频率 */
+    unsigned int policy_min;    /* 生效的 policy->min / max */
+    unsigned int policy_max;
+    int qos_min;                /* 所有 freq_qos 请求聚合后的约束 */
+    int qos_max;
+    unsigned int nr_requests;   /* 本模块在该 policy 上的请求数 */
+};
+
+struct qos_req {
+    struct list_head node;
+    struct cpufreq_policy *policy;  /* 不持有引用，policy 销毁前由 REMOVE_POLICY 通知撤销 */
+    struct freq_qos_request min_req;
+    struct freq_qos_request max_req;
+};
+
+/* 每个打开的 fd 一个 */
+struct ctl_client {
+    struct list_head node;
+    struct list_head reqs;
+};
+
+static LIST_HEAD(clients);
+static DEFINE_MUTEX(clients_lock);     /* 保护 clients 及各 client 的 reqs */
+
 static struct class *cpufreq_class;
 static struct cdev cpufreq_cdev;
 static dev_t devt;
 
+static void qos_req_free(struct qos_req *req)
+{
+    freq_qos_remove_request(&req->min_req);
+    freq_qos_remove_request(&req->max_req);
+    list_del(&req->node);
+    kfree(req);
+}
+
+static int cpufreq_qos_set(struct ctl_client *client, unsigned long arg)
+{
+    struct cpufreq_qos_data data;
+    struct cpufreq_policy *policy;
+    struct qos_req *req;
+    unsigned int old_freq;
+    s32 max;
+    int ret = 0;
+    u64 t0;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+        return -EFAULT;
+    if (data.max && data.min > data.max)
+        return -EINVAL;
+    max = data.max ? data.max : FREQ_QOS_MAX_DEFAULT_VALUE;
+
+    policy = cpufreq_cpu_get(data.cpu);
+    if (!policy)
+        return -EINVAL;
+
+    t0 = ktime_get_ns();
+    old_freq = policy->cur;
+    trace_dvfs_freq_request(data.cpu, old_freq, data.min, DVFS_SRC_QOS);
+
+    mutex_lock(&clients_lock);
+    list_for_each_entry(req, &client->reqs, node) {
+        if (req->policy != policy)
+            continue;
+        if (!data.min && !data.max) {
+            qos_req_free(req);
+            goto out;
+        }
+        ret = freq_qos_update_request(&req->min_req, data.min);
+        if (ret >= 0)
+            ret = freq_qos_update_request(&req->max_req, max);
+        goto out;
+    }
+
+    if (!data.min && !data.max)
+        goto out;
+
+    /*
+     * policy 已从 per-CPU 表摘下说明正在销毁，REMOVE_POLICY 通知可能已经处理过，
+     * 此时再添加的请求没人撤销。摘表先于通知，而通知要取 clients_lock，持锁检查即可。
+     */
+    if (cpufreq_cpu_get_raw(data.cpu) != policy) {
+        ret = -ENODEV;
+        goto out;
+    }
+
+    req = kzalloc(sizeof(*req), GFP_KERNEL);
+    if (!req) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    req->policy = policy;
+    ret = freq_qos_add_request(&policy->constraints, &req->min_req, FREQ_QOS_MIN, data.min);
+    if (ret < 0)
+        goto err_free;
+    ret = freq_qos_add_request(&policy->constraints, &req->max_req, FREQ_QOS_MAX, max);
+    if (ret < 0) {
+        freq_qos_remove_request(&req->min_req);
+        goto err_free;
+    }
+    list_add(&req->node, &client->reqs);
+    goto out;
+
+err_free:
+    kfree(req);
+out:
+    mutex_unlock(&clients_lock);
+    cpufreq_cpu_put(policy);
+    /* policy 的实际更新由 cpufreq 核心异步完成，这里记录约束生效的时刻 */
+    trace_dvfs_freq_apply(data.cpu, old_freq, data.min, DVFS_SRC_QOS, ktime_get_ns() - t0,
+                          ret < 0 ? ret : 0);
+    /* freq_qos_*_request 返回 1 表示聚合值发生变化，不是错误 */
+    return ret < 0 ? ret : 0;
+}
+
+static int cpufreq_qos_query(unsigned long arg)
+{
+    struct cpufreq_qos_query q;
+    struct cpufreq_policy *policy;
+    struct ctl_client *client;
+    struct qos_req *req;
+
+    if (copy_from_user(&q, (void __user *)arg, sizeof(q)))
+        return -EFAULT;
+
+    policy = cpufreq_cpu_get(q.cpu);
+    if (!policy)
+        return -EINVAL;
+
+    q.cur = policy->cur;
+    q.policy_min = policy->min;
+    q.policy_max = policy->max;
+    q.qos_min = freq_qos_read_value(&policy->constraints, FREQ_QOS_MIN);
+    q.qos_max = freq_qos_read_value(&policy->constraints, FREQ_QOS_MAX);
+    q.nr_requests = 0;
+
+    mutex_lock(&clients_lock);
+    list_for_each_entry(client, &clients, node) {
+        list_for_each_entry(req, &client->reqs, node) {
+            if (req->policy == policy)
+                q.nr_requests++;
+        }
+    }
+    mutex_unlock(&clients_lock);
+    cpufreq_cpu_put(policy);
+
+    if (copy_to_user((void __user *)arg, &q, sizeof(q)))
+        return -EFAULT;
+    return 0;
+}
+
+/* policy 销毁（cpufreq 驱动注销）前撤销所有 fd 挂在它上面的请求 */
+static int cpufreq_policy_cb(struct notifier_block *nb, unsigned long event, void *data)
+{
+    struct cpufreq_policy *policy = data;
+    struct ctl_client *client;
+    struct qos_req *req, *tmp;
+
+    if (event != CPUFREQ_REMOVE_POLICY)
+        return NOTIFY_DONE;
+
+    mutex_lock(&clients_lock);
+    list_for_each_entry(client, &clients, node) {
+        list_for_each_entry_safe(req, tmp, &client->reqs, node) {
+            if (req->policy == policy)
+                qos_req_free(req);
+        }
+    }
+    mutex_unlock(&clients_lock);
+    return NOTIFY_OK;
+}
+
+static struct notifier_block cpufreq_policy_nb = {
+    .notifier_call = cpufreq_policy_cb,
+};
+
+static int cpufreq_open(struct inode *inode, struct file *file)
+{
+    struct ctl_client *client;
+
+    client = kzalloc(sizeof(*client), GFP_KERNEL);
+    if (!client)
+        return -ENOMEM;
+    INIT_LIST_HEAD(&client->reqs);
+
+    mutex_lock(&clients_lock);
+    list_add(&client->node, &clients);
+    mutex_unlock(&clients_lock);
+
+    file->private_data = client;
+    return 0;
+}
+
+/* fd 关闭时撤销其全部 freq_qos 请求 */
+static int cpufreq_release(struct inode *inode, struct file *file)
+{
+    struct ctl_client *client = file->private_data;
+    struct qos_req *req, *tmp;
+
+    mutex_lock(&clients_lock);
+    list_for_each_entry_safe(req, tmp, &client->reqs, node)
+        qos_req_free(req);
+    list_del(&client->node);
+    mutex_unlock(&clients_lock);
+
+    kfree(client);
+    return 0;
+}
+
 static long cpufreq_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
     struct cpufreq_ioctl_data data;
     struct cpufreq_policy *policy;
+    unsigned int old_freq;
     int ret = 0;
+    u64 t0;
 
+    if (cmd == IOCTL_QOS_SET)
+        return cpufreq_qos_set(file->private_data, arg);
+    if (cmd == IOCTL_QOS_QUERY)
+        return cpufreq_qos_query(arg);
     if (cmd != IOCTL_SET_FREQ)
         return -EINVAL;
 
     if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
         return -EFAULT;
 
-    pr_info("cpufreq_ctl: set CPU%u -> %u kHz\n", data.cpu, data.freq);
-
     policy = cpufreq_cpu_get(data.cpu);
     if (!policy)
         return -EINVAL;
 
+    t0 = ktime_get_ns();
+    old_freq = policy->cur;
+    trace_dvfs_freq_request(data.cpu, old_freq, data.freq, DVFS_SRC_IOCTL);
+
     ret = cpufreq_driver_target(policy, data.freq, CPUFREQ_RELATION_L);
+    trace_dvfs_freq_apply(data.cpu, old_freq, policy->cur, DVFS_SRC_IOCTL,
+                          ktime_get_ns() - t0, ret);
     cpufreq_cpu_put(policy);
 
-    if (ret)
-        pr_err("cpufreq_ctl: failed to set freq, ret=%d\n", ret);
-    else
-        pr_info("cpufreq_ctl: success\n");
-
     return ret;
 }
 
 static struct file_operations fops = {
     .owner = THIS_MODULE,
+    .open = cpufreq_open,
+    .release = cpufreq_release,
     .unlocked_ioctl = cpufreq_ioctl,
 };
 
@@ -58,10 +299,14 @@ static int __init cpufreq_ctl_init(void)
 {
     int ret;
 
-    ret = alloc_chrdev_region(&devt, 0, 1, DEVICE_NAME);
+    ret = cpufreq_register_notifier(&cpufreq_policy_nb, CPUFREQ_POLICY_NOTIFIER);
     if (ret)
         return ret;
 
+    ret = alloc_chrdev_region(&devt, 0, 1, DEVICE_NAME);
+    if (ret)
+        goto err_notifier;
+
     cdev_init(&cpufreq_cdev, &fops);
     ret = cdev_add(&cpufreq_cdev, devt, 1);
     if (ret)
@@ -81,6 +326,8 @@ err_cdev:
     cdev_del(&cpufreq_cdev);
 err_unregister:
     unregister_chrdev_region(devt, 1);
+err_notifier:
+    cpufreq_unregister_notifier(&cpufreq_policy_nb, CPUFREQ_POLICY_NOTIFIER);
     return ret;
 }
 
@@ -90,6 +337,7 @@ static void __exit cpufreq_ctl_exit(void)
     class_destroy(cpufreq_class);
     cdev_del(&cpufreq_cdev);
     unregister_chrdev_region(devt, 1);
+    cpufreq_unregister_notifier(&cpufreq_policy_nb, CPUFREQ_POLICY_NOTIFIER);
     pr_info("cpufreq_ctl: module unloaded\n");
 }
 
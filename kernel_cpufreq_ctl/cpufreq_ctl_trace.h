@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* cpufreq_ctl_trace.h: 调频请求/执行的 tracepoint，替代 ioctl 路径上的 printk */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cpufreq_ctl
+
+#if !defined(_CPUFREQ_CTL_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _CPUFREQ_CTL_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/* DVFS_SRC_* 来源编号与 dvfs_freq_* 事件布局与 sched_cpufreq、cpufreq_sim 共用 */
+#include "dvfs_trace_common.h"
+
+/* 收到请求：old 为当时的 policy->cur，new 为请求频率（qos 请求为下限） */
+DEFINE_DVFS_FREQ_REQUEST_EVENT(dvfs_freq_request);
+
+/* 请求执行完毕：new 为执行后的 policy->cur（qos 请求为已登记的下限），latency_ns 自对应的 dvfs_freq_request 起计 */
+DEFINE_DVFS_FREQ_DONE_EVENT(dvfs_freq_apply);
+
+#endif /* _CPUFREQ_CTL_TRACE_H */
+
+/* 头文件与模块源码同目录，Makefile 中需 -I$(src) */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE cpufreq_ctl_trace
+#include <trace/define_trace.h>
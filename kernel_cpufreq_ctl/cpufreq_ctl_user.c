@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
@@ -7,19 +8,102 @@
 #define DEVICE_PATH "/dev/cpufreq_ctl"
 
 #define IOCTL_SET_FREQ _IOW('q', 1, struct cpufreq_ioctl_data)
+#define IOCTL_QOS_SET   _IOW('q', 2, struct cpufreq_qos_data)
+#define IOCTL_QOS_QUERY _IOWR('q', 3, struct cpufreq_qos_query)
 
 struct cpufreq_ioctl_data {
     unsigned int cpu;
     unsigned int freq;
 };
 
+struct cpufreq_qos_data {
+    unsigned int cpu;
+    unsigned int min;
+    unsigned int max;
+};
+
+struct cpufreq_qos_query {
+    unsigned int cpu;
+    unsigned int cur;
+    unsigned int policy_min;
+    unsigned int policy_max;
+    int qos_min;
+    int qos_max;
+    unsigned int nr_requests;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: sudo %s <cpu_id> <freq_khz>                         set frequency directly\n", prog);
+    fprintf(stderr, "       sudo %s qos <cpu_id> <min_khz> <max_khz> [hold_s]   hold a freq_qos request (max 0 = no cap)\n", prog);
+    fprintf(stderr, "       sudo %s query <cpu_id>                              show the aggregated constraints\n", prog);
+}
+
+static int do_query(int fd, unsigned int cpu)
+{
+    struct cpufreq_qos_query q;
+
+    memset(&q, 0, sizeof(q));
+    q.cpu = cpu;
+    if (ioctl(fd, IOCTL_QOS_QUERY, &q) < 0) {
+        perror("ioctl");
+        return 1;
+    }
+    printf("CPU%u: cur=%u kHz policy=[%u, %u] kHz qos=[%d, %d] kHz cpufreq_ctl requests=%u\n",
+           q.cpu, q.cur, q.policy_min, q.policy_max, q.qos_min, q.qos_max, q.nr_requests);
+    return 0;
+}
+
+/* 请求随 fd 存活：持有 hold_s 秒（0 = 直到 Ctrl-C）后关闭 fd 自动撤销 */
+static int do_qos(int fd, unsigned int cpu, unsigned int min, unsigned int max, int hold_s)
+{
+    struct cpufreq_qos_data data = { .cpu = cpu, .min = min, .max = max };
+
+    if (ioctl(fd, IOCTL_QOS_SET, &data) < 0) {
+        perror("ioctl");
+        return 1;
+    }
+    printf("CPU%u freq_qos request [%u, %u] kHz held for %s\n", cpu, min, max,
+           hold_s > 0 ? "the given time" : "until interrupted");
+    do_query(fd, cpu);
+
+    if (hold_s > 0)
+        sleep(hold_s);
+    else
+        pause();
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
-    int fd;
+    int fd, ret;
     struct cpufreq_ioctl_data data;
 
+    if (argc == 3 && !strcmp(argv[1], "query")) {
+        fd = open(DEVICE_PATH, O_RDWR);
+        if (fd < 0) {
+            perror("open");
+            return 1;
+        }
+        ret = do_query(fd, atoi(argv[2]));
+        close(fd);
+        return ret;
+    }
+
+    if ((argc == 5 || argc == 6) && !strcmp(argv[1], "qos")) {
+        fd = open(DEVICE_PATH, O_RDWR);
+        if (fd < 0) {
+            perror("open");
+            return 1;
+        }
+        ret = do_qos(fd, atoi(argv[2]), strtoul(argv[3], NULL, 0), strtoul(argv[4], NULL, 0),
+                     argc == 6 ? atoi(argv[5]) : 0);
+        close(fd);
+        return ret;
+    }
+
     if (argc != 3) {
-        fprintf(stderr, "Usage: sudo %s <cpu_id> <freq_khz>\n", argv[0]);
+        usage(argv[0]);
         return 1;
     }
 
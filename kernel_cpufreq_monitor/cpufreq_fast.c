@@ -1,9 +1,75 @@
 #include <linux/module.h>
 #include <linux/cpufreq.h>
 #include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 #include <linux/uaccess.h>
+#include <linux/perf_event.h>
+#include <linux/percpu.h>
+#include <linux/mutex.h>
+#include <linux/math64.h>
+#include <linux/cpuhotplug.h>
+#ifdef CONFIG_X86
+#include <asm/msr.h>
+#include <asm/cpufeature.h>
+#include <asm/tsc.h>
+#endif
+
+/*
+ * /proc/cpufreq_fast: CPU0 的请求频率 policy->cur（单个数字，dvfs_governor 等工具直接解析）
+ * /proc/cpufreq_eff:  每个 CPU 的请求频率与实际交付频率对照，统计区间为相邻两次读取之间
+ *
+ * 交付频率的来源按优先级：
+ *   aperfmperf   x86 APERF/MPERF 计数器：freq = cpu_khz * dAPERF / dMPERF，busy = dMPERF / dTSC
+ *   perf_cycles  内核 perf 计数器 (CPU cycles)：freq = dcycles / 非 idle 时间
+ *   none         两者都不可用（无 PMU 的虚拟机等），只输出请求频率
+ *
+ * perf_cycles 在模块加载期间每个在线 CPU 钉住一个硬件计数器（pinned），
+ * 会与 perf、cpufreq_monitor_user 等用户争用 PMU。各 CPU 的状态随 CPU 热插拔建立/释放。
+ */
 
 static struct proc_dir_entry *entry;
+static struct proc_dir_entry *eff_entry;
+static enum cpuhp_state eff_hp_state;
+
+enum eff_src {
+    EFF_NONE,
+    EFF_APERFMPERF,
+    EFF_PERF_CYCLES,
+};
+
+static const char * const eff_src_names[] = {
+    [EFF_NONE]        = "none",
+    [EFF_APERFMPERF]  = "aperfmperf",
+    [EFF_PERF_CYCLES] = "perf_cycles",
+};
+
+struct eff_sample {
+    u64 aperf, mperf, tsc;      // aperfmperf
+    u64 cycles;                 // perf_cycles
+    u64 idle_us, wall_us;       // get_cpu_idle_time
+};
+
+struct eff_cpu {
+    enum eff_src src;
+    struct perf_event *event;
+    struct eff_sample last;     // 上一次读取时的采样
+};
+
+struct eff_result {
+    unsigned int delivered;     // kHz，0 表示整个区间都在 idle
+    unsigned int busy_pm;       // 忙碌比例，千分比
+    u64 interval_us;
+};
+
+static DEFINE_PER_CPU(struct eff_cpu, eff_cpus);
+static DEFINE_MUTEX(eff_lock);  // 保护各 CPU 的状态，并发读者各自得到完整区间；热插拔回调同样持有
+
+static struct perf_event_attr eff_cycles_attr = {
+    .type   = PERF_TYPE_HARDWARE,
+    .config = PERF_COUNT_HW_CPU_CYCLES,
+    .size   = sizeof(struct perf_event_attr),
+    .pinned = 1,
+};
 
 static ssize_t read_freq(struct file *file, char __user *buf, size_t len, loff_t *offset)
 {
@@ -24,16 +90,202 @@ static const struct proc_ops fops = {
     .proc_read = read_freq,
 };
 
+#ifdef CONFIG_X86
+// 在目标 CPU 上执行（IPI 上下文，已关中断），三个计数器在同一时刻读出
+static void aperfmperf_sample(void *info)
+{
+    struct eff_sample *s = info;
+
+    rdmsrl(MSR_IA32_APERF, s->aperf);
+    rdmsrl(MSR_IA32_MPERF, s->mperf);
+    s->tsc = rdtsc();
+}
+#endif
+
+static int eff_take_sample(unsigned int cpu, struct eff_cpu *ec, struct eff_sample *s)
+{
+    u64 enabled, running;
+
+    s->idle_us = get_cpu_idle_time(cpu, &s->wall_us, 0);
+    switch (ec->src) {
+#ifdef CONFIG_X86
+    case EFF_APERFMPERF:
+        return smp_call_function_single(cpu, aperfmperf_sample, s, 1);
+#endif
+    case EFF_PERF_CYCLES:
+        s->cycles = perf_event_read_value(ec->event, &enabled, &running);
+        return running ? 0 : -ENODATA;
+    default:
+        return -ENODEV;
+    }
+}
+
+static void eff_compute(const struct eff_cpu *ec, const struct eff_sample *prev,
+                        const struct eff_sample *cur, struct eff_result *r)
+{
+    u64 dwall = cur->wall_us - prev->wall_us;
+    u64 didle = min(cur->idle_us - prev->idle_us, dwall);
+    u64 busy_us = dwall - didle;
+
+    r->interval_us = dwall;
+    r->delivered = 0;
+    r->busy_pm = dwall ? div64_u64(busy_us * 1000, dwall) : 0;
+
+    switch (ec->src) {
+#ifdef CONFIG_X86
+    case EFF_APERFMPERF: {
+        u64 da = cur->aperf - prev->aperf;
+        u64 dm = cur->mperf - prev->mperf;
+        u64 dt = cur->tsc - prev->tsc;
+
+        // MPERF 只在 C0 以固定频率计数，比 idle 时间统计更准
+        if (dt)
+            r->busy_pm = div64_u64(min(dm, dt) * 1000, dt);
+        // 区间很长时先缩小，避免 da * cpu_khz 溢出
+        while (da > (1ULL << 40)) {
+            da >>= 1;
+            dm >>= 1;
+        }
+        if (dm)
+            r->delivered = div64_u64(da * cpu_khz, dm);
+        break;
+    }
+#endif
+    case EFF_PERF_CYCLES:
+        // cycles / us = MHz；idle 时周期计数器通常停止，所以按非 idle 时间折算
+        if (busy_us)
+            r->delivered = div64_u64((cur->cycles - prev->cycles) * 1000, busy_us);
+        break;
+    default:
+        break;
+    }
+}
+
+static void eff_release_cpu(struct eff_cpu *ec)
+{
+    if (ec->event)
+        perf_event_release_kernel(ec->event);
+    ec->event = NULL;
+    ec->src = EFF_NONE;
+}
+
+static void eff_setup_cpu(unsigned int cpu)
+{
+    struct eff_cpu *ec = per_cpu_ptr(&eff_cpus, cpu);
+
+    ec->src = EFF_NONE;
+#ifdef CONFIG_X86
+    if (boot_cpu_has(X86_FEATURE_APERFMPERF) && cpu_khz)
+        ec->src = EFF_APERFMPERF;
+#endif
+    if (ec->src == EFF_NONE) {
+        struct perf_event *event;
+
+        event = perf_event_create_kernel_counter(&eff_cycles_attr, cpu, NULL, NULL, NULL);
+        if (IS_ERR(event))
+            return;
+        ec->event = event;
+        ec->src = EFF_PERF_CYCLES;
+    }
+
+    // 建立第一次读取的基线
+    if (eff_take_sample(cpu, ec, &ec->last))
+        eff_release_cpu(ec);
+}
+
+// 热插拔回调：在目标 CPU 上运行，加载时对已在线的 CPU 各调用一次 online
+static int eff_cpu_online(unsigned int cpu)
+{
+    mutex_lock(&eff_lock);
+    eff_setup_cpu(cpu);
+    mutex_unlock(&eff_lock);
+    return 0;
+}
+
+static int eff_cpu_offline(unsigned int cpu)
+{
+    mutex_lock(&eff_lock);
+    eff_release_cpu(per_cpu_ptr(&eff_cpus, cpu));
+    mutex_unlock(&eff_lock);
+    return 0;
+}
+
+static int eff_show(struct seq_file *m, void *v)
+{
+    unsigned int cpu;
+
+    mutex_lock(&eff_lock);
+    seq_printf(m, "%-4s %13s %13s %8s %11s %s\n",
+               "cpu", "requested_khz", "delivered_khz", "busy_pct", "interval_ms", "source");
+    for_each_online_cpu(cpu) {
+        struct eff_cpu *ec = per_cpu_ptr(&eff_cpus, cpu);
+        unsigned int req = cpufreq_quick_get(cpu);     // 0: 该 CPU 没有 cpufreq policy
+        struct eff_sample cur;
+        struct eff_result r;
+
+        if (ec->src == EFF_NONE || eff_take_sample(cpu, ec, &cur)) {
+            seq_printf(m, "%-4u %13u %13s %8s %11s %s\n", cpu, req, "-", "-", "-", "none");
+            continue;
+        }
+        eff_compute(ec, &ec->last, &cur, &r);
+        ec->last = cur;
+        seq_printf(m, "%-4u %13u %13u %6u.%u %11llu %s\n", cpu, req, r.delivered,
+                   r.busy_pm / 10, r.busy_pm % 10, r.interval_us / 1000, eff_src_names[ec->src]);
+    }
+    mutex_unlock(&eff_lock);
+    return 0;
+}
+
+static int eff_open(struct inode *inode, struct file *file)
+{
+    // 一次分配足够大的缓冲区：seq_file 缓冲区不够时会重新调用 show，第二次的采样区间几乎为 0
+    return single_open_size(file, eff_show, NULL, 128 + nr_cpu_ids * 80);
+}
+
+static const struct proc_ops eff_fops = {
+    .proc_open    = eff_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
 static int __init cpufreq_fast_init(void)
 {
+    int ret;
+
+    // 在 cpus_read_lock 下对已在线的 CPU 调用 online 回调，之后上线的 CPU 同样会建立计数器
+    ret = cpuhp_setup_state(CPUHP_AP_ONLINE_DYN, "cpufreq_fast:online", eff_cpu_online, eff_cpu_offline);
+    if (ret < 0)
+        return ret;
+    eff_hp_state = ret;
+
     entry = proc_create("cpufreq_fast", 0444, NULL, &fops);
-    pr_info("cpufreq_fast module loaded.\n");
+    if (!entry) {
+        ret = -ENOMEM;
+        goto err_hp;
+    }
+    eff_entry = proc_create("cpufreq_eff", 0444, NULL, &eff_fops);
+    if (!eff_entry) {
+        ret = -ENOMEM;
+        goto err_entry;
+    }
+    pr_info("cpufreq_fast module loaded (effective frequency source: %s).\n",
+            eff_src_names[per_cpu(eff_cpus, cpumask_first(cpu_online_mask)).src]);
     return 0;
+
+err_entry:
+    proc_remove(entry);
+err_hp:
+    cpuhp_remove_state(eff_hp_state);
+    return ret;
 }
 
 static void __exit cpufreq_fast_exit(void)
 {
+    proc_remove(eff_entry);
     proc_remove(entry);
+    // 对在线 CPU 调用 offline 回调释放计数器
+    cpuhp_remove_state(eff_hp_state);
     pr_info("cpufreq_fast module unloaded.\n");
 }
 
@@ -41,5 +293,5 @@ module_init(cpufreq_fast_init);
 module_exit(cpufreq_fast_exit);
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("zs");
-MODULE_VERSION("1.0");
-MODULE_DESCRIPTION("A simple module to read current CPU frequency from /proc/cpufreq_fast");
\ No newline at end of file
+MODULE_VERSION("1.1");
+MODULE_DESCRIPTION("Report requested and delivered (APERF/MPERF or PMU cycles) CPU frequency via /proc");
@@ -1,44 +1,343 @@
+// cpufreq_monitor_user.c
+// Build: gcc -O2 -o cpufreq_monitor_user cpufreq_monitor_user.c
+// Purpose: sample per-CPU frequency, IPC and busy fraction at a fixed interval.
+//
+//   sudo ./cpufreq_monitor_user <interval_ms> <log_path> [bin_path]
+//
+// 每个 CPU 打开一组 perf 计数器（cycles 为组长，instructions 为成员），
+// 每次采样用一次 read() 读出整组，保证两个值出自同一时刻。
+// 忙碌比例优先取 /proc/cpufreq_eff（cpufreq_fast 模块，内核 idle 时间统计，微秒精度），
+// 模块未加载时退回 /proc/stat，后者以 10 ms 为单位，短采样间隔下只剩 0 或 100%。
+// log_path 为文本日志；bin_path 可选，写入定长 64 字节的 struct cpu_sample 记录，便于离线分析。
+// perf 不可用时（perf_event_paranoid 限制、虚拟机没有 PMU）仍记录频率和利用率，计数器字段为 0。
+
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
 #include <unistd.h>
 #include <time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #define PROC_PATH "/proc/cpufreq_fast"
+#define EFF_PATH  "/proc/cpufreq_eff"
+#define MAX_CPUS  256
+
+// /proc/stat 以 USER_HZ (100) 计数：低于该间隔 busy 与 eff_khz 没有意义，1 s 以上误差约 1%
+#define STAT_MIN_INTERVAL_MS 100
+
+// 一个 CPU 一次采样；按 cache line 对齐，二进制文件中每条记录 64 字节
+struct cpu_sample {
+    uint64_t ts_ns;             // CLOCK_REALTIME
+    uint32_t cpu;
+    uint32_t req_khz;           // 请求频率：CPU0 读 cpufreq_fast，其余读 scaling_cur_freq
+    uint32_t eff_khz;           // 交付频率：cycles / 非 idle 时间，0 = 无计数器或整段 idle
+    uint32_t busy_pm;           // 忙碌比例（千分比），来源见 SAMPLE_F_BUSY_EFF
+    uint64_t cycles;            // 本区间增量（多路复用时已按 enabled/running 缩放）
+    uint64_t instructions;
+    uint64_t busy_ns;           // 非 idle 时间 = 区间长度 * busy_pm
+    uint32_t ipc_milli;         // instructions * 1000 / cycles
+    uint32_t flags;             // SAMPLE_F_*
+} __attribute__((aligned(64)));
+
+#define SAMPLE_F_PERF       0x1 // 计数器有效
+#define SAMPLE_F_SCALED     0x2 // 计数器被多路复用，值为估算
+#define SAMPLE_F_BUSY_EFF   0x4 // busy 来自 /proc/cpufreq_eff；否则来自 /proc/stat（10 ms 粒度）
+
+// 与 PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING 的 read() 布局一致
+struct group_read {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[2];         // cycles, instructions
+};
+
+// CPU 范围的 task-clock/cpu-clock 在 idle 时也走，不能用来算忙碌时间，所以组里只有两个硬件计数器
+#define NR_EVENTS 2
+
+struct cpu_state {
+    int fd[NR_EVENTS];          // fd[0] 为组长
+    struct group_read last;
+    unsigned long long stat_busy, stat_total;
+};
+
+static struct cpu_state cpus[MAX_CPUS];
+static int ncpus;
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static int perf_open(uint32_t type, uint64_t config, int cpu, int group_fd)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = group_fd < 0;   // 组长先关着，成员加齐后再统一打开
+    return syscall(__NR_perf_event_open, &attr, -1, cpu, group_fd, 0);
+}
+
+// 整个 CPU 的计数器组（pid = -1）；失败时 fd[0] = -1
+static void open_group(struct cpu_state *c, int cpu)
+{
+    static const struct { uint32_t type; uint64_t config; } ev[NR_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    };
+    int i;
+
+    for (i = 0; i < NR_EVENTS; i++) {
+        c->fd[i] = perf_open(ev[i].type, ev[i].config, cpu, i ? c->fd[0] : -1);
+        if (c->fd[i] < 0) {
+            while (--i >= 0)
+                close(c->fd[i]);
+            c->fd[0] = -1;
+            return;
+        }
+    }
+    ioctl(c->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(c->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static int read_group(struct cpu_state *c, struct group_read *g)
+{
+    if (c->fd[0] < 0)
+        return -1;
+    if (read(c->fd[0], g, sizeof(*g)) != (ssize_t)sizeof(*g) || g->nr != NR_EVENTS)
+        return -1;
+    return 0;
+}
+
+static unsigned int read_uint(const char *path)
+{
+    unsigned int v = 0;
+    FILE *f = fopen(path, "r");
+
+    if (f) {
+        if (fscanf(f, "%u", &v) != 1)
+            v = 0;
+        fclose(f);
+    }
+    return v;
+}
+
+static unsigned int read_req_freq(int cpu)
+{
+    char path[128];
+    unsigned int freq;
+
+    if (cpu == 0 && (freq = read_uint(PROC_PATH)) != 0)
+        return freq;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+    return read_uint(path);
+}
+
+// 从 /proc/stat 更新各 CPU 的 busy 比例（千分比），返回 0 表示成功
+static int sample_stat(uint32_t *busy_pm)
+{
+    char line[512];
+    FILE *f = fopen("/proc/stat", "r");
+
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long v[8] = { 0 }, busy, total;
+        int cpu, i;
+
+        if (sscanf(line, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu", &cpu,
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) < 5)
+            continue;
+        if (cpu < 0 || cpu >= ncpus)
+            continue;
+        for (total = 0, i = 0; i < 8; i++)
+            total += v[i];
+        busy = total - v[3] - v[4];     // 去掉 idle 和 iowait
+        if (total > cpus[cpu].stat_total)
+            busy_pm[cpu] = (uint32_t)((busy - cpus[cpu].stat_busy) * 1000 / (total - cpus[cpu].stat_total));
+        cpus[cpu].stat_busy = busy;
+        cpus[cpu].stat_total = total;
+    }
+    fclose(f);
+    return 0;
+}
+
+/*
+ * 从 /proc/cpufreq_eff 读各 CPU 的忙碌比例（千分比），区间为相邻两次读取之间。
+ * 成功的 CPU 在 fine 中置 1；文件不存在返回 -1。其它进程同时读会缩短本次区间，但比例仍然有效。
+ */
+static int sample_eff(uint32_t *busy_pm, uint8_t *fine)
+{
+    char line[256];
+    FILE *f = fopen(EFF_PATH, "r");
+
+    if (!f)
+        return -1;
+    memset(fine, 0, MAX_CPUS);
+    while (fgets(line, sizeof(line), f)) {
+        unsigned int cpu, req, ip, fp;
+
+        // cpu requested_khz delivered_khz busy_pct ...；没有来源的 CPU 该列为 "-"
+        if (sscanf(line, "%u %u %*s %u.%u", &cpu, &req, &ip, &fp) != 4 || cpu >= (unsigned int)ncpus)
+            continue;
+        busy_pm[cpu] = ip * 10 + fp;
+        fine[cpu] = 1;
+    }
+    fclose(f);
+    return 0;
+}
+
+static void fill_counters(struct cpu_sample *s, struct cpu_state *c, uint64_t interval_ns)
+{
+    struct group_read g;
+    uint64_t d_en, d_run, busy_ns;
+    double scale = 1.0;
+
+    busy_ns = interval_ns * s->busy_pm / 1000;
+    s->busy_ns = busy_ns;
+    if (read_group(c, &g))
+        return;
+    d_en = g.time_enabled - c->last.time_enabled;
+    d_run = g.time_running - c->last.time_running;
+    if (d_run && d_run < d_en) {
+        scale = (double)d_en / d_run;
+        s->flags |= SAMPLE_F_SCALED;
+    }
+    if (d_run) {
+        s->cycles = (uint64_t)((g.values[0] - c->last.values[0]) * scale);
+        s->instructions = (uint64_t)((g.values[1] - c->last.values[1]) * scale);
+        s->flags |= SAMPLE_F_PERF;
+    }
+    c->last = g;
+
+    if (s->cycles)
+        s->ipc_milli = (uint32_t)(s->instructions * 1000 / s->cycles);
+    // 空闲时周期计数器基本停走，按非 idle 时间折算出实际运行频率
+    if (busy_ns)
+        s->eff_khz = (uint32_t)(s->cycles * 1000000ULL / busy_ns);
+}
 
 int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <interval_ms> <log_path>\n", argv[0]);
+    if (argc < 3 || argc > 4) {
+        fprintf(stderr, "Usage: %s <interval_ms> <log_path> [bin_path]\n", argv[0]);
         return 1;
     }
 
     int interval = atoi(argv[1]);
     const char *log_path = argv[2];
+    uint32_t busy_pm[MAX_CPUS] = { 0 };
+    uint8_t busy_fine[MAX_CPUS] = { 0 };
+    int i, nperf = 0, have_eff;
+
+    if (interval <= 0) {
+        fprintf(stderr, "interval_ms must be > 0\n");
+        return 1;
+    }
 
     FILE *log = fopen(log_path, "w");
     if (!log) {
         perror("fopen");
         return 1;
     }
+    FILE *bin = NULL;
+    if (argc == 4) {
+        bin = fopen(argv[3], "wb");
+        if (!bin) {
+            perror("fopen");
+            fclose(log);
+            return 1;
+        }
+    }
 
-    struct timespec ts;
-    while (1) {
-        FILE *f = fopen(PROC_PATH, "r");
-        if (!f) {
-            perror("open /proc/cpufreq_fast");
-            break;
+    ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (ncpus > MAX_CPUS)
+        ncpus = MAX_CPUS;
+    for (i = 0; i < ncpus; i++) {
+        open_group(&cpus[i], i);
+        if (cpus[i].fd[0] >= 0) {
+            read_group(&cpus[i], &cpus[i].last);
+            nperf++;
         }
+    }
+    if (!nperf)
+        fprintf(stderr, "perf_event_open failed on all CPUs (need root or perf_event_paranoid <= 0); "
+                        "logging frequency and utilization only\n");
+    sample_stat(busy_pm);   // 建立 /proc/stat 基线
+    have_eff = !sample_eff(busy_pm, busy_fine);
+    if (!have_eff && interval < STAT_MIN_INTERVAL_MS)
+        fprintf(stderr, "warning: %s not available, busy comes from /proc/stat in 10 ms units; "
+                        "busy_pct and eff_khz are meaningless below %d ms\n", EFF_PATH, STAT_MIN_INTERVAL_MS);
 
-        int freq = 0;
-        fscanf(f, "%d", &freq);
-        fclose(f);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
 
-        clock_gettime(CLOCK_REALTIME, &ts);
-        fprintf(log, "%ld.%03ld %d\n", ts.tv_sec, ts.tv_nsec / 1000000, freq);
-        fflush(log);
+    fprintf(log, "# ts cpu req_khz eff_khz busy_pct ipc cycles instructions busy_ms\n");
 
+    struct timespec ts, mono;
+    uint64_t last_ns, now;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    last_ns = (uint64_t)mono.tv_sec * 1000000000ULL + mono.tv_nsec;
+
+    while (!stop) {
         usleep(interval * 1000);
+
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        clock_gettime(CLOCK_REALTIME, &ts);
+        now = (uint64_t)mono.tv_sec * 1000000000ULL + mono.tv_nsec;
+        if (sample_stat(busy_pm)) {
+            perror("open /proc/stat");
+            break;
+        }
+        // 有 /proc/cpufreq_eff 的 CPU 覆盖 /proc/stat 的粗粒度结果
+        if (have_eff && sample_eff(busy_pm, busy_fine))
+            memset(busy_fine, 0, sizeof(busy_fine));
+
+        for (i = 0; i < ncpus; i++) {
+            struct cpu_sample s;
+
+            memset(&s, 0, sizeof(s));
+            s.ts_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+            s.cpu = i;
+            s.req_khz = read_req_freq(i);
+            s.busy_pm = busy_pm[i];
+            if (busy_fine[i])
+                s.flags |= SAMPLE_F_BUSY_EFF;
+            fill_counters(&s, &cpus[i], now - last_ns);
+
+            fprintf(log, "%ld.%03ld %u %u %u %u.%u %u.%03u %llu %llu %.3f\n",
+                    ts.tv_sec, ts.tv_nsec / 1000000, s.cpu, s.req_khz, s.eff_khz,
+                    s.busy_pm / 10, s.busy_pm % 10, s.ipc_milli / 1000, s.ipc_milli % 1000,
+                    (unsigned long long)s.cycles, (unsigned long long)s.instructions,
+                    s.busy_ns / 1e6);
+            if (bin && fwrite(&s, sizeof(s), 1, bin) != 1) {
+                perror("fwrite");
+                stop = 1;
+            }
+        }
+        fflush(log);
+        last_ns = now;
     }
 
+    for (i = 0; i < ncpus; i++) {
+        int j;
+
+        if (cpus[i].fd[0] < 0)
+            continue;
+        for (j = NR_EVENTS - 1; j >= 0; j--)
+            close(cpus[i].fd[j]);
+    }
+    if (bin)
+        fclose(bin);
     fclose(log);
     return 0;
 }
@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: GPL-2.0
+// cpufreq_sim.c: 虚拟 cpufreq 驱动，为没有真实调频硬件的 VM 提供可复现的 DVFS 后端
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/cpufreq.h>
+#include <linux/cpumask.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/random.h>
+#include <linux/spinlock.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/version.h>
+
+#define CREATE_TRACE_POINTS
+#include "cpufreq_sim_trace.h"
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("zs");
+MODULE_DESCRIPTION("Simulated cpufreq driver for benchmarking DVFS control paths");
+MODULE_VERSION("1.0");
+
+/* --- 模块参数 --- */
+#define MAX_FREQS 32
+
+static unsigned int freqs[MAX_FREQS] = { 600000, 800000, 1000000, 1200000, 1500000 };
+static int nr_freqs = 5;
+module_param_array(freqs, uint, &nr_freqs, 0444);
+MODULE_PARM_DESC(freqs, "Frequency table in kHz, e.g. freqs=600000,1000000,1500000");
+
+static unsigned int cpus_per_policy = 1;
+module_param(cpus_per_policy, uint, 0444);
+MODULE_PARM_DESC(cpus_per_policy, "CPUs sharing one policy (1 = per-CPU, 4 = 4-CPU clusters)");
+
+static unsigned int latency_us = 100;
+module_param(latency_us, uint, 0644);
+MODULE_PARM_DESC(latency_us, "Simulated transition latency for ->target_index (us, sleeps)");
+
+static bool fast_switch = true;
+module_param(fast_switch, bool, 0444);
+MODULE_PARM_DESC(fast_switch, "Advertise fast switching (->fast_switch from scheduler context)");
+
+static unsigned int fast_latency_us = 2;
+module_param(fast_latency_us, uint, 0644);
+MODULE_PARM_DESC(fast_latency_us, "Simulated latency for ->fast_switch (us, busy-waits)");
+
+static unsigned int fail_every;
+module_param(fail_every, uint, 0644);
+MODULE_PARM_DESC(fail_every, "Fail every Nth transition (0 = off)");
+
+static unsigned int fail_percent;
+module_param(fail_percent, uint, 0644);
+MODULE_PARM_DESC(fail_percent, "Fail transitions with this probability in percent (0 = off)");
+
+static unsigned int log_size = 4096;
+module_param(log_size, uint, 0444);
+MODULE_PARM_DESC(log_size, "Number of transitions kept in /proc/cpufreq_sim");
+
+#define PROC_NAME "cpufreq_sim"
+
+/* --- 状态 --- */
+
+/* 每个 policy 的当前频率 */
+struct sim_policy {
+    unsigned int cur;
+};
+
+/* 一次频率切换记录 */
+struct sim_rec {
+    u64 ts_ns;
+    u32 latency_ns;
+    u16 cpu;
+    u8 fast;
+    s8 ret;
+    unsigned int old_freq;
+    unsigned int new_freq;
+};
+
+static struct cpufreq_frequency_table *sim_table;
+static struct sim_rec *recs;            /* 环形缓冲，容量 log_size */
+static unsigned long nr_recs;           /* 累计写入条数 */
+static unsigned long nr_transitions;
+static unsigned long nr_failures;
+static DEFINE_RAW_SPINLOCK(rec_lock);   /* fast_switch 可能在调度器上下文中调用 */
+
+/* --- 工具函数 --- */
+
+static void sim_record(struct cpufreq_policy *policy, unsigned int old_freq,
+                       unsigned int new_freq, u64 start_ns, bool fast, int ret)
+{
+    u64 now = ktime_get_ns();
+    unsigned long flags;
+    struct sim_rec *r;
+
+    raw_spin_lock_irqsave(&rec_lock, flags);
+    r = &recs[nr_recs++ % log_size];
+    r->ts_ns = now;
+    r->latency_ns = (u32)min_t(u64, now - start_ns, U32_MAX);
+    r->cpu = policy->cpu;
+    r->fast = fast;
+    r->ret = ret;
+    r->old_freq = old_freq;
+    r->new_freq = new_freq;
+    nr_transitions++;
+    if (ret)
+        nr_failures++;
+    raw_spin_unlock_irqrestore(&rec_lock, flags);
+
+    trace_dvfs_freq_complete(policy->cpu, old_freq, new_freq,
+                             fast ? DVFS_SRC_FAST : DVFS_SRC_TARGET, now - start_ns, ret);
+}
+
+/* 失败注入：按固定间隔或按概率 */
+static bool sim_should_fail(void)
+{
+    unsigned int every = READ_ONCE(fail_every);
+    unsigned int pct = READ_ONCE(fail_percent);
+
+    if (every && (READ_ONCE(nr_transitions) + 1) % every == 0)
+        return true;
+    if (pct && get_random_u32() % 100 < pct)
+        return true;
+    return false;
+}
+
+/* --- cpufreq 驱动回调 --- */
+
+static int sim_target_index(struct cpufreq_policy *policy, unsigned int index)
+{
+    struct sim_policy *sp = policy->driver_data;
+    unsigned int new_freq = sim_table[index].frequency;
+    unsigned int old_freq = sp->cur;
+    unsigned int lat = READ_ONCE(latency_us);
+    u64 start = ktime_get_ns();
+    int ret = 0;
+
+    if (lat)
+        usleep_range(lat, lat + lat / 10 + 1);
+
+    if (sim_should_fail())
+        ret = -EIO;
+    else
+        WRITE_ONCE(sp->cur, new_freq);
+
+    sim_record(policy, old_freq, new_freq, start, false, ret);
+    return ret;
+}
+
+/* 调度器上下文，不能睡眠；返回实际设置的频率，0 表示失败 */
+static unsigned int sim_fast_switch(struct cpufreq_policy *policy,
+                                    unsigned int target_freq)
+{
+    struct sim_policy *sp = policy->driver_data;
+    unsigned int old_freq = sp->cur;
+    unsigned int lat = READ_ONCE(fast_latency_us);
+    u64 start = ktime_get_ns();
+    int index;
+
+    index = cpufreq_table_find_index_dl(policy, target_freq);
+    if (lat)
+        udelay(lat);
+
+    if (sim_should_fail()) {
+        sim_record(policy, old_freq, sim_table[index].frequency, start, true, -EIO);
+        return 0;
+    }
+
+    WRITE_ONCE(sp->cur, sim_table[index].frequency);
+    sim_record(policy, old_freq, sp->cur, start, true, 0);
+    return sp->cur;
+}
+
+static unsigned int sim_get(unsigned int cpu)
+{
+    struct cpufreq_policy *policy = cpufreq_cpu_get_raw(cpu);
+    struct sim_policy *sp;
+
+    if (!policy)
+        return 0;
+    sp = policy->driver_data;
+    return sp ? READ_ONCE(sp->cur) : 0;
+}
+
+static int sim_cpu_init(struct cpufreq_policy *policy)
+{
+    struct sim_policy *sp;
+    unsigned int group = policy->cpu / cpus_per_policy;
+    int cpu;
+
+    sp = kzalloc(sizeof(*sp), GFP_KERNEL);
+    if (!sp)
+        return -ENOMEM;
+    sp->cur = sim_table[0].frequency;
+
+    /* 同一组内的 CPU 共享一个 policy */
+    for_each_possible_cpu(cpu) {
+        if (cpu / cpus_per_policy == group)
+            cpumask_set_cpu(cpu, policy->cpus);
+    }
+
+    policy->driver_data = sp;
+    policy->freq_table = sim_table;
+    policy->cpuinfo.transition_latency = latency_us * NSEC_PER_USEC;
+    policy->fast_switch_possible = fast_switch;
+    return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,11,0)
+static void sim_cpu_exit(struct cpufreq_policy *policy)
+{
+    kfree(policy->driver_data);
+    policy->driver_data = NULL;
+}
+#else
+static int sim_cpu_exit(struct cpufreq_policy *policy)
+{
+    kfree(policy->driver_data);
+    policy->driver_data = NULL;
+    return 0;
+}
+#endif
+
+static struct cpufreq_driver sim_driver = {
+    .name         = "cpufreq_sim",
+    .verify       = cpufreq_generic_frequency_table_verify,
+    .target_index = sim_target_index,
+    .fast_switch  = sim_fast_switch,
+    .get          = sim_get,
+    .init         = sim_cpu_init,
+    .exit         = sim_cpu_exit,
+    .attr         = cpufreq_generic_attr,
+};
+
+/* --- /proc/cpufreq_sim --- */
+
+static int proc_show(struct seq_file *m, void *v)
+{
+    struct sim_rec *snap;
+    unsigned long flags, transitions, failures;
+    unsigned long total, first, i;
+
+    snap = vmalloc(sizeof(*snap) * log_size);
+    if (!snap)
+        return -ENOMEM;
+
+    /* 先在锁内拷贝快照，避免持锁输出 */
+    raw_spin_lock_irqsave(&rec_lock, flags);
+    memcpy(snap, recs, sizeof(*snap) * log_size);
+    total = nr_recs;
+    transitions = nr_transitions;
+    failures = nr_failures;
+    raw_spin_unlock_irqrestore(&rec_lock, flags);
+
+    seq_printf(m, "transitions: %lu\n", transitions);
+    seq_printf(m, "failures: %lu\n", failures);
+    seq_printf(m, "latency_us: %u fast_latency_us: %u fail_every: %u fail_percent: %u\n",
+               READ_ONCE(latency_us), READ_ONCE(fast_latency_us),
+               READ_ONCE(fail_every), READ_ONCE(fail_percent));
+    seq_printf(m, "%-16s %4s %4s %9s %9s %10s %4s\n",
+               "ts_ns", "cpu", "fast", "old_khz", "new_khz", "latency_ns", "ret");
+
+    first = total > log_size ? total - log_size : 0;
+    for (i = first; i < total; i++) {
+        struct sim_rec *r = &snap[i % log_size];
+
+        seq_printf(m, "%-16llu %4u %4u %9u %9u %10u %4d\n",
+                   r->ts_ns, r->cpu, r->fast, r->old_freq, r->new_freq,
+                   r->latency_ns, r->ret);
+    }
+
+    vfree(snap);
+    return 0;
+}
+
+static int proc_open_fn(struct inode *inode, struct file *file)
+{
+    return single_open(file, proc_show, NULL);
+}
+
+/* 写入 "clear" 清空记录 */
+static ssize_t proc_write_fn(struct file *file, const char __user *ubuf,
+                             size_t count, loff_t *ppos)
+{
+    char buf[16];
+    unsigned long flags;
+
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+    if (!sysfs_streq(buf, "clear"))
+        return -EINVAL;
+
+    raw_spin_lock_irqsave(&rec_lock, flags);
+    nr_recs = 0;
+    nr_transitions = 0;
+    nr_failures = 0;
+    raw_spin_unlock_irqrestore(&rec_lock, flags);
+    return count;
+}
+
+static const struct proc_ops proc_fops = {
+    .proc_open    = proc_open_fn,
+    .proc_read    = seq_read,
+    .proc_write   = proc_write_fn,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* --- 模块初始化 / 卸载 --- */
+
+static int __init cpufreq_sim_init(void)
+{
+    int i, ret;
+
+    if (nr_freqs <= 0 || !cpus_per_policy || !log_size) {
+        pr_err("cpufreq_sim: invalid parameters\n");
+        return -EINVAL;
+    }
+    /* 频点须为正且严格递增：0、重复或乱序的表会被 cpuinfo 范围计算和 governor 的查表直接信任 */
+    for (i = 0; i < nr_freqs; i++) {
+        if (!freqs[i] || freqs[i] >= CPUFREQ_ENTRY_INVALID || (i && freqs[i] <= freqs[i - 1])) {
+            pr_err("cpufreq_sim: freqs[%d]=%u: entries must be non-zero and strictly ascending\n",
+                   i, freqs[i]);
+            return -EINVAL;
+        }
+    }
+
+    sim_table = kcalloc(nr_freqs + 1, sizeof(*sim_table), GFP_KERNEL);
+    if (!sim_table)
+        return -ENOMEM;
+    for (i = 0; i < nr_freqs; i++) {
+        sim_table[i].driver_data = i;
+        sim_table[i].frequency = freqs[i];
+    }
+    sim_table[nr_freqs].frequency = CPUFREQ_TABLE_END;
+
+    recs = vzalloc(sizeof(*recs) * log_size);
+    if (!recs) {
+        ret = -ENOMEM;
+        goto err_table;
+    }
+
+    if (!proc_create(PROC_NAME, 0644, NULL, &proc_fops)) {
+        pr_err("cpufreq_sim: proc_create failed\n");
+        ret = -ENOMEM;
+        goto err_recs;
+    }
+
+    ret = cpufreq_register_driver(&sim_driver);
+    if (ret) {
+        pr_err("cpufreq_sim: register driver failed: %d (another cpufreq driver loaded?)\n", ret);
+        goto err_proc;
+    }
+
+    pr_info("cpufreq_sim: registered, %d freqs, %u CPUs per policy, fast_switch=%d\n",
+            nr_freqs, cpus_per_policy, fast_switch);
+    return 0;
+
+err_proc:
+    remove_proc_entry(PROC_NAME, NULL);
+err_recs:
+    vfree(recs);
+err_table:
+    kfree(sim_table);
+    return ret;
+}
+
+static void __exit cpufreq_sim_exit(void)
+{
+    cpufreq_unregister_driver(&sim_driver);
+    remove_proc_entry(PROC_NAME, NULL);
+    vfree(recs);
+    kfree(sim_table);
+    pr_info("cpufreq_sim: unloaded\n");
+}
+
+module_init(cpufreq_sim_init);
+module_exit(cpufreq_sim_exit);
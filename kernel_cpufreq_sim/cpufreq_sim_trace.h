@@ -0,0 +1,24 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* cpufreq_sim_trace.h: 虚拟驱动完成频率切换的 tracepoint */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cpufreq_sim
+
+#if !defined(_CPUFREQ_SIM_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _CPUFREQ_SIM_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/* DVFS_SRC_* 来源编号与 dvfs_freq_* 事件布局与 sched_cpufreq、cpufreq_ctl 共用 */
+#include "dvfs_trace_common.h"
+
+/* 驱动回调返回：source 为 target/fast，latency_ns 为回调内部耗时，ret 非 0 表示注入的失败 */
+DEFINE_DVFS_FREQ_DONE_EVENT(dvfs_freq_complete);
+
+#endif /* _CPUFREQ_SIM_TRACE_H */
+
+/* 头文件与模块源码同目录，Makefile 中需 -I$(src) */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE cpufreq_sim_trace
+#include <trace/define_trace.h>
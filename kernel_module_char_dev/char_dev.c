@@ -5,6 +5,15 @@
 #include <linux/cdev.h>     // 包含 cdev 结构和相关函数
 #include <linux/device.h>   // 包含 class 和 device_create 等函数
 #include <linux/uaccess.h>  // 包含 copy_to_user 和 copy_from_user
+#include <linux/vmalloc.h>  // vzalloc, vfree
+#include <linux/atomic.h>   // atomic_long_*
+#include <linux/wait.h>     // 等待队列
+#include <linux/poll.h>     // poll
+#include <linux/log2.h>     // roundup_pow_of_two
+#include <linux/mutex.h>
+
+#define CREATE_TRACE_POINTS
+#include "char_dev_trace.h" // 读写路径的 tracepoint，替代 printk
 
 #define DEVICE_NAME "char_dev"
 #define CLASS_NAME  "char_class"
@@ -13,7 +22,17 @@
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Your Name");
 MODULE_DESCRIPTION("A simple character device kernel module");
-MODULE_VERSION("1.1");
+MODULE_VERSION("1.2");
+
+// --- 模块参数 ---
+// ring=1: 多生产者单消费者 (MPSC) 无锁环形模式，替代单一全局缓冲区
+static bool ring = false;
+module_param(ring, bool, 0444);
+MODULE_PARM_DESC(ring, "Use the lock-free multi-producer ring instead of the single shared buffer");
+
+static unsigned int ring_slots = 4096;
+module_param(ring_slots, uint, 0444);
+MODULE_PARM_DESC(ring_slots, "Number of ring slots (rounded up to a power of two)");
 
 // --- 全局变量 ---
 static int    major_number;                 // 存储我们的设备主号
@@ -23,11 +42,45 @@ static struct class* char_class  = NULL;   // 设备类
 static struct device* char_device = NULL;   // 设备实例
 static struct cdev    my_cdev;              // 字符设备结构
 
+// --- MPSC 环形模式 ---
+// 每次 write 写入一个槽位，一次最多 RING_PAYLOAD 字节
+#define RING_SLOT_SIZE    256
+#define RING_PAYLOAD      (RING_SLOT_SIZE - 16)
+#define RING_LEN_DISCARD  U32_MAX           // 生产者拷贝失败，消费者跳过
+
+struct ring_slot {
+    unsigned long seq;                      // == ticket + 1 表示该 ticket 的数据已提交
+    u32 len;
+    u32 cpu;                                // 写入者所在 CPU
+    char data[RING_PAYLOAD];
+};
+
+// ring 模式下 read 返回的每条记录：头部后紧跟 len 字节数据，再用 0 填充到 8 字节边界，
+// 保证下一条记录的头部在用户缓冲区中自然对齐
+#define RING_REC_ALIGN 8
+struct ring_rec_hdr {
+    u32 len;
+    u32 cpu;
+    u64 seq;                                // 全局写入序号 (ticket)
+};
+
+static struct ring_slot *ring_buf;
+static unsigned long ring_mask;
+static atomic_long_t ring_head;             // 下一个 ticket，生产者 fetch-add 领取
+static atomic_long_t ring_credits;          // 空闲槽位数，生产者先领额度再领 ticket
+static unsigned long ring_tail;             // 下一个待消费的 ticket，仅消费者修改
+static DEFINE_MUTEX(ring_read_lock);        // 多个 reader 串行化为单一消费者
+static DECLARE_WAIT_QUEUE_HEAD(ring_data_wq);   // 消费者等待数据
+static DECLARE_WAIT_QUEUE_HEAD(ring_space_wq);  // 生产者等待空位
+
 // --- 文件操作函数声明 ---
 static int     dev_open(struct inode *, struct file *);
 static int     dev_release(struct inode *, struct file *);
 static ssize_t dev_read(struct file *, char *, size_t, loff_t *);
 static ssize_t dev_write(struct file *, const char *, size_t, loff_t *);
+static ssize_t ring_read(struct file *, char __user *, size_t, loff_t *);
+static ssize_t ring_write(struct file *, const char __user *, size_t, loff_t *);
+static __poll_t ring_poll(struct file *, poll_table *);
 
 // 将文件操作与我们的函数关联起来
 static struct file_operations fops = {
@@ -38,14 +91,37 @@ static struct file_operations fops = {
     .owner   = THIS_MODULE,
 };
 
+static struct file_operations ring_fops = {
+    .open    = dev_open,
+    .read    = ring_read,
+    .write   = ring_write,
+    .poll    = ring_poll,
+    .release = dev_release,
+    .owner   = THIS_MODULE,
+};
+
 // --- 模块初始化函数 ---
 static int __init char_dev_init(void) {
     pr_info("CharDevModule: Initializing the character device...\n");
 
+    // 0. ring 模式：分配槽位，初始额度为全部槽位
+    if (ring) {
+        ring_slots = roundup_pow_of_two(max(ring_slots, 2U));
+        ring_buf = vzalloc(array_size(ring_slots, sizeof(struct ring_slot)));
+        if (!ring_buf) {
+            pr_err("CharDevModule: Failed to allocate %u ring slots\n", ring_slots);
+            return -ENOMEM;
+        }
+        ring_mask = ring_slots - 1;
+        atomic_long_set(&ring_credits, ring_slots);
+        pr_info("CharDevModule: MPSC ring mode, %u slots of %d bytes\n", ring_slots, RING_PAYLOAD);
+    }
+
     // 1. 动态分配一个主设备号
     // alloc_chrdev_region(dev_t* dev, unsigned int firstminor, unsigned int count, const char* name)
     if (alloc_chrdev_region(&major_number, 0, 1, DEVICE_NAME) < 0) {
         pr_err("CharDevModule: Failed to allocate a major number\n");
+        vfree(ring_buf);
         return -1;
     }
     // MAJOR(major_number) 宏可以从 dev_t 中提取主设备号
@@ -53,7 +129,7 @@ static int __init char_dev_init(void) {
 
     // 2. 初始化 cdev 结构，并与文件操作关联
     // void cdev_init(struct cdev *cdev, const struct file_operations *fops)
-    cdev_init(&my_cdev, &fops);
+    cdev_init(&my_cdev, ring ? &ring_fops : &fops);
     my_cdev.owner = THIS_MODULE;
 
     // 3. 将 cdev 添加到内核
@@ -62,6 +138,7 @@ static int __init char_dev_init(void) {
         pr_err("CharDevModule: Failed to add the cdev to the kernel\n");
         // 如果失败，需要释放已分配的设备号
         unregister_chrdev_region(major_number, 1);
+        vfree(ring_buf);
         return -1;
     }
 
@@ -72,6 +149,7 @@ static int __init char_dev_init(void) {
         pr_err("CharDevModule: Failed to create the struct class\n");
         cdev_del(&my_cdev);
         unregister_chrdev_region(major_number, 1);
+        vfree(ring_buf);
         return PTR_ERR(char_class);
     }
     pr_info("CharDevModule: Device class created successfully.\n");
@@ -84,6 +162,7 @@ static int __init char_dev_init(void) {
         class_destroy(char_class);
         cdev_del(&my_cdev);
         unregister_chrdev_region(major_number, 1);
+        vfree(ring_buf);
         return PTR_ERR(char_device);
     }
     pr_info("CharDevModule: Device created successfully at /dev/%s\n", DEVICE_NAME);
@@ -97,6 +176,7 @@ static void __exit char_dev_exit(void) {
     class_destroy(char_class);                // 4. 销毁设备类
     cdev_del(&my_cdev);                       // 3. 从内核移除 cdev
     unregister_chrdev_region(major_number, 1);// 1. 释放主设备号
+    vfree(ring_buf);                          // 0. 释放环形缓冲区
 
     pr_info("CharDevModule: Goodbye!\n");
 }
@@ -104,12 +184,10 @@ static void __exit char_dev_exit(void) {
 // --- 文件操作函数实现 ---
 
 static int dev_open(struct inode *inodep, struct file *filep) {
-    pr_info("CharDevModule: Device has been opened.\n");
     return 0;
 }
 
 static int dev_release(struct inode *inodep, struct file *filep) {
-    pr_info("CharDevModule: Device successfully closed.\n");
     return 0;
 }
 
@@ -136,7 +214,7 @@ static ssize_t dev_read(struct file *filep, char *user_buffer, size_t len, loff_
     // 更新文件偏移量
     *offset += bytes_to_read;
     
-    pr_info("CharDevModule: Sent %d characters to the user\n", bytes_to_read);
+    trace_char_dev_dequeue(bytes_to_read, *offset, bytes_stored);
     return bytes_to_read; // 返回实际读取的字节数
 }
 
@@ -159,9 +237,132 @@ static ssize_t dev_write(struct file *filep, const char *user_buffer, size_t len
        bytes_stored--;
     }
 
-    pr_info("CharDevModule: Received %d characters from user: '%s'\n", bytes_to_write, kernel_buffer);
+    trace_char_dev_enqueue(bytes_to_write, bytes_stored);
     return bytes_to_write; // 返回实际写入的字节数
 }
 
+// --- MPSC 环形模式实现 ---
+
+// 生产者：先用 fetch-sub 领一个空位额度（不足时归还），再用 fetch-add 领 ticket。
+// 额度保证 ticket 对应的槽位已被消费者释放，整个过程不取锁。
+static ssize_t ring_write(struct file *filep, const char __user *user_buffer, size_t len, loff_t *offset) {
+    struct ring_slot *slot;
+    unsigned long ticket;
+    ssize_t ret = len;
+
+    if (len > RING_PAYLOAD)
+        return -EMSGSIZE;
+
+    while (atomic_long_dec_return(&ring_credits) < 0) {
+        atomic_long_inc(&ring_credits);
+        if (filep->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        if (wait_event_interruptible(ring_space_wq, atomic_long_read(&ring_credits) > 0))
+            return -ERESTARTSYS;
+    }
+
+    ticket = atomic_long_fetch_add(1, &ring_head);
+    slot = &ring_buf[ticket & ring_mask];
+
+    // 直接拷贝进槽位；失败也必须提交，否则消费者会一直等待这个 ticket
+    slot->cpu = raw_smp_processor_id();
+    if (copy_from_user(slot->data, user_buffer, len)) {
+        slot->len = RING_LEN_DISCARD;
+        ret = -EFAULT;
+    } else {
+        slot->len = len;
+    }
+    smp_store_release(&slot->seq, ticket + 1);   // 提交：数据先于 seq 可见
+
+    if (wq_has_sleeper(&ring_data_wq))
+        wake_up(&ring_data_wq);
+
+    trace_char_dev_enqueue(len, ticket + 1 - READ_ONCE(ring_tail));
+    return ret;
+}
+
+// 单一消费者：按 ticket 顺序批量读出已提交的记录，遇到未提交的槽位即停止
+static ssize_t ring_read(struct file *filep, char __user *user_buffer, size_t len, loff_t *offset) {
+    size_t copied = 0;
+    unsigned long consumed = 0;
+    ssize_t ret = 0;
+
+    if (mutex_lock_interruptible(&ring_read_lock))
+        return -ERESTARTSYS;
+
+    for (;;) {
+        unsigned long tail = ring_tail;
+        struct ring_slot *slot = &ring_buf[tail & ring_mask];
+        struct ring_rec_hdr hdr;
+
+        if (smp_load_acquire(&slot->seq) != tail + 1) {
+            // 只跳过了 DISCARD 槽位时不能返回 0（读者会当成 EOF），继续等待真正的记录
+            if (copied)
+                break;
+            if (filep->f_flags & O_NONBLOCK) {
+                ret = -EAGAIN;
+                break;
+            }
+            // 睡眠前先唤醒等额度的生产者，否则双方可能互相等待
+            if (consumed) {
+                wake_up(&ring_space_wq);
+                consumed = 0;
+            }
+            ret = wait_event_interruptible(ring_data_wq,
+                                           smp_load_acquire(&slot->seq) == tail + 1);
+            if (ret)
+                break;
+            continue;
+        }
+
+        if (slot->len != RING_LEN_DISCARD) {
+            size_t pad = ALIGN(slot->len, RING_REC_ALIGN) - slot->len;
+
+            // 用户缓冲区放不下下一条完整记录（含填充）
+            if (copied + sizeof(hdr) + slot->len + pad > len) {
+                if (!copied)
+                    ret = -EINVAL;
+                break;
+            }
+            hdr.len = slot->len;
+            hdr.cpu = slot->cpu;
+            hdr.seq = tail;
+            if (copy_to_user(user_buffer + copied, &hdr, sizeof(hdr)) ||
+                copy_to_user(user_buffer + copied + sizeof(hdr), slot->data, slot->len) ||
+                clear_user(user_buffer + copied + sizeof(hdr) + slot->len, pad)) {
+                ret = -EFAULT;
+                break;
+            }
+            copied += sizeof(hdr) + slot->len + pad;
+            trace_char_dev_dequeue(slot->len, tail, atomic_long_read(&ring_head) - tail - 1);
+        }
+
+        // 读完槽位后再归还额度，生产者才可能覆盖它
+        WRITE_ONCE(ring_tail, tail + 1);
+        smp_mb__before_atomic();
+        atomic_long_inc(&ring_credits);
+        consumed++;
+    }
+    mutex_unlock(&ring_read_lock);
+
+    if (consumed)
+        wake_up(&ring_space_wq);
+    return copied ? copied : ret;
+}
+
+static __poll_t ring_poll(struct file *filep, poll_table *wait) {
+    unsigned long tail = READ_ONCE(ring_tail);
+    __poll_t mask = 0;
+
+    poll_wait(filep, &ring_data_wq, wait);
+    poll_wait(filep, &ring_space_wq, wait);
+
+    if (smp_load_acquire(&ring_buf[tail & ring_mask].seq) == tail + 1)
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if (atomic_long_read(&ring_credits) > 0)
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    return mask;
+}
+
 module_init(char_dev_init);
-module_exit(char_dev_exit);
\ No newline at end of file
+module_exit(char_dev_exit);
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+// char_dev_trace.h: 字符设备读写路径的 tracepoint
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM char_dev
+
+#if !defined(_CHAR_DEV_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _CHAR_DEV_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// write: 用户数据存入内核缓冲区
+TRACE_EVENT(char_dev_enqueue,
+
+    TP_PROTO(int len, int stored),
+
+    TP_ARGS(len, stored),
+
+    TP_STRUCT__entry(
+        __field(int, len)       // 本次写入的字节数
+        __field(int, stored)    // 写入后缓冲区中的有效字节数；ring 模式下为待消费记录数
+    ),
+
+    TP_fast_assign(
+        __entry->len    = len;
+        __entry->stored = stored;
+    ),
+
+    TP_printk("len=%d stored=%d", __entry->len, __entry->stored)
+);
+
+// read: 缓冲区数据交给用户
+TRACE_EVENT(char_dev_dequeue,
+
+    TP_PROTO(int len, loff_t offset, int stored),
+
+    TP_ARGS(len, offset, stored),
+
+    TP_STRUCT__entry(
+        __field(int,    len)    // 本次读出的字节数
+        __field(loff_t, offset) // 读完后的文件偏移；ring 模式下为该记录的 ticket
+        __field(int,    stored)
+    ),
+
+    TP_fast_assign(
+        __entry->len    = len;
+        __entry->offset = offset;
+        __entry->stored = stored;
+    ),
+
+    TP_printk("len=%d offset=%lld stored=%d",
+              __entry->len, __entry->offset, __entry->stored)
+);
+
+#endif /* _CHAR_DEV_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE char_dev_trace
+#include <trace/define_trace.h>
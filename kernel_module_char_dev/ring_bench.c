@@ -0,0 +1,216 @@
+// ring_bench.c
+// Build: gcc -O2 -pthread -o ring_bench ring_bench.c
+// Purpose: scale 1..N producer threads (each pinned to its own core) writing into char_dev's MPSC ring
+//          (insmod char_dev.ko ring=1) while one pinned collector thread drains it in batches.
+//
+// 每条记录的负载开头是 (producer, seq)，collector 检查每个生产者的序号是否连续，
+// 顺序错乱或丢失都会计入 errors。
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEVICE      "/dev/char_dev"
+#define READ_BATCH  (256 << 10)
+#define MAX_PAYLOAD 240         /* 与 char_dev.c 中 RING_PAYLOAD 一致 */
+
+/* 与 char_dev.c 中 struct ring_rec_hdr 一致；每条记录按 8 字节对齐，len 不含填充 */
+#define RING_REC_ALIGN 8
+struct ring_rec_hdr {
+    uint32_t len;
+    uint32_t cpu;
+    uint64_t seq;
+};
+
+struct payload {
+    uint32_t producer;
+    uint32_t pad;
+    uint64_t seq;
+};
+
+static int nr_cpus;
+static unsigned long records;       /* 每个生产者写入的记录数 */
+static size_t payload_len;
+static pthread_barrier_t start_barrier;
+
+struct producer {
+    pthread_t thread;
+    int id;
+    int fd;
+    uint64_t write_ns;              /* 该线程所有 write() 的总耗时 */
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void pin(int cpu)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu % nr_cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void *producer_fn(void *arg)
+{
+    struct producer *p = arg;
+    char buf[MAX_PAYLOAD];
+    struct payload *pl = (struct payload *)buf;
+    unsigned long i;
+    uint64_t t0;
+
+    /* collector 占用 CPU 0，生产者从 CPU 1 开始 */
+    pin(p->id + 1);
+    memset(buf, 0xa5, sizeof(buf));
+    pl->producer = p->id;
+    pthread_barrier_wait(&start_barrier);
+
+    t0 = now_ns();
+    for (i = 0; i < records; i++) {
+        pl->seq = i;
+        /* collector 要收齐全部记录才结束，写失败直接退出 */
+        if (write(p->fd, buf, payload_len) != (ssize_t)payload_len) {
+            perror("write " DEVICE);
+            exit(1);
+        }
+    }
+    p->write_ns = now_ns() - t0;
+    return NULL;
+}
+
+struct run_result {
+    double elapsed_ns;
+    double write_ns;                /* 平均每次 write() 的耗时 */
+    unsigned long batches;
+    unsigned long errors;
+    unsigned int cpus_seen;
+};
+
+/* collector：阻塞读，直到收齐 nr * records 条记录 */
+static int collect(int fd, int nr, struct run_result *r)
+{
+    unsigned long total = (unsigned long)nr * records, got = 0;
+    uint64_t *next = calloc(nr, sizeof(*next));
+    char *buf = malloc(READ_BATCH);
+    uint64_t cpu_mask = 0;
+
+    if (!next || !buf) {
+        free(next);
+        free(buf);
+        return -1;
+    }
+    memset(r, 0, sizeof(*r));
+    while (got < total) {
+        ssize_t n = read(fd, buf, READ_BATCH), off = 0;
+
+        if (n < 0) {
+            perror("read " DEVICE);
+            break;
+        }
+        r->batches++;
+        while (off + (ssize_t)sizeof(struct ring_rec_hdr) <= n) {
+            struct ring_rec_hdr *h = (struct ring_rec_hdr *)(buf + off);
+            struct payload *pl = (struct payload *)(h + 1);
+
+            if (h->len < sizeof(*pl) || pl->producer >= (uint32_t)nr || pl->seq != next[pl->producer])
+                r->errors++;
+            else
+                next[pl->producer]++;
+            cpu_mask |= 1ull << (h->cpu & 63);
+            off += sizeof(*h) + ((h->len + RING_REC_ALIGN - 1) & ~(RING_REC_ALIGN - 1));
+            got++;
+        }
+    }
+    r->cpus_seen = __builtin_popcountll(cpu_mask);
+    free(next);
+    free(buf);
+    return 0;
+}
+
+static int run(int nr, struct run_result *r)
+{
+    struct producer *prod = calloc(nr, sizeof(*prod));
+    int i, rfd, ret;
+    uint64_t t0;
+
+    rfd = open(DEVICE, O_RDONLY);
+    if (!prod || rfd < 0) {
+        perror("open " DEVICE);
+        free(prod);
+        return -1;
+    }
+    pthread_barrier_init(&start_barrier, NULL, nr + 1);
+    for (i = 0; i < nr; i++) {
+        prod[i].id = i;
+        prod[i].fd = open(DEVICE, O_WRONLY);
+        if (prod[i].fd < 0) {
+            perror("open " DEVICE);
+            exit(1);
+        }
+        pthread_create(&prod[i].thread, NULL, producer_fn, &prod[i]);
+    }
+
+    pin(0);
+    pthread_barrier_wait(&start_barrier);
+    t0 = now_ns();
+    ret = collect(rfd, nr, r);
+    r->elapsed_ns = now_ns() - t0;
+
+    r->write_ns = 0;
+    for (i = 0; i < nr; i++) {
+        pthread_join(prod[i].thread, NULL);
+        close(prod[i].fd);
+        r->write_ns += (double)prod[i].write_ns / records / nr;
+    }
+    pthread_barrier_destroy(&start_barrier);
+    close(rfd);
+    free(prod);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_prod, nr;
+
+    nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    max_prod = argc > 1 ? atoi(argv[1]) : (nr_cpus > 1 ? nr_cpus - 1 : 1);
+    records = argc > 2 ? strtoul(argv[2], NULL, 0) : 200000;
+    payload_len = argc > 3 ? strtoul(argv[3], NULL, 0) : 64;
+    if (argc > 4 || max_prod <= 0 || !records || payload_len < sizeof(struct payload) ||
+        payload_len > MAX_PAYLOAD) {
+        fprintf(stderr, "Usage: sudo %s [max_producers=ncpu-1] [records_per_producer=200000] [payload=64 (16..%d)]\n",
+                argv[0], MAX_PAYLOAD);
+        return 1;
+    }
+
+    printf("records/producer=%lu payload=%zu cpus=%d (collector on cpu0)\n", records, payload_len, nr_cpus);
+    printf("%9s %10s %9s %12s %10s %10s %5s %6s\n",
+           "producers", "Mrec/s", "MB/s", "Mrec/s/prod", "write_ns", "rec/batch", "cpus", "errors");
+
+    for (nr = 1; nr <= max_prod; nr++) {
+        struct run_result r;
+        double total = (double)nr * records, mrps;
+
+        if (run(nr, &r))
+            return 1;
+        mrps = total / r.elapsed_ns * 1e3;
+        printf("%9d %10.3f %9.1f %12.3f %10.1f %10.1f %5u %6lu\n",
+               nr, mrps, mrps * payload_len, mrps / nr, r.write_ns,
+               r.batches ? total / r.batches : 0.0, r.cpus_seen, r.errors);
+    }
+    return 0;
+}
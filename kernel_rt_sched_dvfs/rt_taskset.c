@@ -0,0 +1,589 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/prctl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <sched.h>
+#include "rt_workload.h"
+
+#define PR_SET_CPUFREQ 0x6001
+#define HINT_DEV "/dev/sched_cpufreq"
+
+// 与 sched_cpufreq_kthread 模块一致的 ioctl（未打补丁内核上 prctl 不可用时使用）
+struct sched_cpufreq_hint {
+    int pid;
+    unsigned int freq;
+};
+#define IOCTL_SET_HINT _IOW('s', 1, struct sched_cpufreq_hint)
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+struct sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t  sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+#define MAX_TASKS 64
+#define NSEC_PER_SEC 1000000000ULL
+#define MAX_INSTS (MAX_TASKS * 16)
+#define DEFAULT_RECORDS 65536
+#define HIST_BUCKETS 24     // log2(us) 桶：[0,1us) [1,2us) [2,4us) ... 最后一桶为溢出
+
+// 任务集描述中的一行
+struct task_desc {
+    char name[32];
+    uint64_t period_ns;
+    uint64_t wcet_ns;
+    int prio;
+    int cpu;            // -1 = 不绑核
+    unsigned int freq;  // kHz，0 = 不设置频率提示
+    int count;          // 该任务的线程实例数
+    int policy;         // SCHED_FIFO / SCHED_RR / SCHED_DEADLINE
+    enum rt_work_kind work;
+    uint64_t work_units;    // 每个作业的固定工作量；未显式给出时按 wcet_us 标定
+};
+
+// 单个作业的时间戳，均为 CLOCK_MONOTONIC ns
+struct job_rec {
+    uint64_t release_ns;    // clock_nanosleep 的绝对目标时刻
+    uint64_t start_ns;      // 唤醒后开始执行
+    uint64_t finish_ns;     // 作业完成
+};
+
+struct hist {
+    uint64_t b[HIST_BUCKETS];
+};
+
+// 每线程统计；仅由所属线程写，退出后由主线程读，无需加锁
+struct job_stats {
+    uint64_t jobs;
+    uint64_t misses;        // finish > release + period（隐式截止期）
+    uint64_t resp_min, resp_max, resp_sum;
+    uint64_t jitter_max, jitter_sum;
+    int64_t  late_max;
+    struct hist resp;       // 响应时间 finish - release
+    struct hist jitter;     // 唤醒抖动 start - release
+    struct hist late;       // lateness > 0（超出截止期）
+    struct hist slack;      // lateness <= 0 时的 |lateness|
+};
+
+// 实时统计，发布在 POSIX 共享内存中供外部（如 dvfs_governor 的 slack 策略）读取
+#define RT_LIVE_SHM "/rt_taskset_stats"
+#define RT_LIVE_MAGIC 0x52544c53    // "RTLS"
+
+struct rt_live_stat {
+    uint64_t period_ns;
+    uint64_t jobs;
+    uint64_t misses;
+    int64_t  last_lateness_ns;      // <= 0 即剩余 slack
+    int32_t  cpu;                   // -1 = 未绑核
+    uint32_t pad;
+};
+
+struct rt_live_stats {
+    uint32_t magic;
+    uint32_t n;
+    struct rt_live_stat s[MAX_INSTS];
+};
+
+struct task_inst {
+    const struct task_desc *desc;
+    int idx;
+    pthread_t tid;
+    struct job_rec *recs;   // 预分配环形缓冲，超出后覆盖最旧记录
+    uint64_t nrecs;
+    struct job_stats st;
+    struct rt_live_stat *live;      // 可能为 NULL
+};
+
+static struct task_desc tasks[MAX_TASKS];
+static int ntasks;
+static struct timespec start_time;      // 所有线程的同步首次释放时刻
+static uint64_t records_per_thread = DEFAULT_RECORDS;
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static void ts_add_ns(struct timespec *ts, uint64_t ns)
+{
+    ts->tv_sec += ns / NSEC_PER_SEC;
+    ts->tv_nsec += ns % NSEC_PER_SEC;
+    while (ts->tv_nsec >= (long)NSEC_PER_SEC) {
+        ts->tv_nsec -= NSEC_PER_SEC;
+        ts->tv_sec++;
+    }
+}
+
+static uint64_t ts_to_ns(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts_to_ns(&ts);
+}
+
+static void hist_add(struct hist *h, uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    int i = 0;
+
+    while (us && i < HIST_BUCKETS - 1) {
+        us >>= 1;
+        i++;
+    }
+    h->b[i]++;
+}
+
+// 作业完成后在 RT 循环内调用：只做算术和一次数组写入
+static void job_account(struct task_inst *inst, const struct job_rec *r)
+{
+    struct job_stats *st = &inst->st;
+    uint64_t resp = r->finish_ns - r->release_ns;
+    uint64_t jitter = r->start_ns > r->release_ns ? r->start_ns - r->release_ns : 0;
+    int64_t late = (int64_t)(r->finish_ns - (r->release_ns + inst->desc->period_ns));
+
+    inst->recs[st->jobs % inst->nrecs] = *r;
+    st->jobs++;
+
+    if (resp < st->resp_min || st->jobs == 1)
+        st->resp_min = resp;
+    if (resp > st->resp_max)
+        st->resp_max = resp;
+    st->resp_sum += resp;
+    hist_add(&st->resp, resp);
+
+    if (jitter > st->jitter_max)
+        st->jitter_max = jitter;
+    st->jitter_sum += jitter;
+    hist_add(&st->jitter, jitter);
+
+    if (late > st->late_max || st->jobs == 1)
+        st->late_max = late;
+    if (late > 0) {
+        st->misses++;
+        hist_add(&st->late, late);
+    } else {
+        hist_add(&st->slack, -late);
+    }
+
+    if (inst->live) {
+        __atomic_store_n(&inst->live->last_lateness_ns, late, __ATOMIC_RELAXED);
+        __atomic_store_n(&inst->live->misses, st->misses, __ATOMIC_RELAXED);
+        __atomic_store_n(&inst->live->jobs, st->jobs, __ATOMIC_RELEASE);
+    }
+}
+
+static int parse_policy(const char *s)
+{
+    if (!strcmp(s, "fifo"))
+        return SCHED_FIFO;
+    if (!strcmp(s, "rr"))
+        return SCHED_RR;
+    if (!strcmp(s, "deadline") || !strcmp(s, "dl"))
+        return SCHED_DEADLINE;
+    return -1;
+}
+
+// 格式：name period_us wcet_us prio cpu freq_khz count [fifo|rr|deadline [work[:units]]]
+static int load_taskset(const char *path)
+{
+    char line[256];
+    int lineno = 0;
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        struct task_desc *t = &tasks[ntasks];
+        unsigned long long period_us, wcet_us;
+        char policy[16] = "fifo";
+        char work[48] = "spin";
+        char *p = line;
+        int n;
+
+        lineno++;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == '#' || *p == '\n' || *p == '\0')
+            continue;
+
+        if (ntasks >= MAX_TASKS) {
+            fprintf(stderr, "%s:%d: too many tasks (max %d)\n", path, lineno, MAX_TASKS);
+            goto err;
+        }
+
+        n = sscanf(p, "%31s %llu %llu %d %d %u %d %15s %47s", t->name, &period_us, &wcet_us,
+                   &t->prio, &t->cpu, &t->freq, &t->count, policy, work);
+        if (n < 7) {
+            fprintf(stderr, "%s:%d: expected: name period_us wcet_us prio cpu freq_khz count [policy [work]]\n",
+                    path, lineno);
+            goto err;
+        }
+        if (rt_work_parse(work, &t->work, &t->work_units) != 0) {
+            fprintf(stderr, "%s:%d: unknown work '%s'\n", path, lineno, work);
+            goto err;
+        }
+        t->period_ns = period_us * 1000ULL;
+        t->wcet_ns = wcet_us * 1000ULL;
+        t->policy = parse_policy(policy);
+        if (t->policy < 0 || t->count <= 0 || !t->period_ns || t->wcet_ns > t->period_ns) {
+            fprintf(stderr, "%s:%d: invalid task '%s'\n", path, lineno, t->name);
+            goto err;
+        }
+        // 内核要求 SCHED_DEADLINE 任务的亲和性覆盖整个 root domain，绑核后 sched_setattr 返回 EPERM
+        if (t->policy == SCHED_DEADLINE && t->cpu >= 0) {
+            fprintf(stderr, "%s:%d: deadline task '%s' cannot be pinned, use cpu -1\n",
+                    path, lineno, t->name);
+            goto err;
+        }
+        // sched_cpufreq 只对 FIFO/RR 任务应用频率提示
+        if (t->policy == SCHED_DEADLINE && t->freq)
+            fprintf(stderr, "%s:%d: warning: freq hint of deadline task '%s' is ignored by sched_cpufreq\n",
+                    path, lineno, t->name);
+        ntasks++;
+    }
+
+    fclose(f);
+    return ntasks ? 0 : -1;
+
+err:
+    fclose(f);
+    return -1;
+}
+
+static int set_freq_hint(unsigned int freq)
+{
+    struct sched_cpufreq_hint hint = { .pid = 0, .freq = freq };
+    int fd, ret;
+
+    // 补丁内核：prctl 写 task_struct->cpufreq；否则走模块的 ioctl
+    if (prctl(PR_SET_CPUFREQ, freq, 0, 0, 0) == 0)
+        return 0;
+
+    fd = open(HINT_DEV, O_RDWR);
+    if (fd < 0)
+        return -1;
+    ret = ioctl(fd, IOCTL_SET_HINT, &hint);
+    close(fd);
+    return ret;
+}
+
+static int set_sched(const struct task_desc *t)
+{
+    if (t->policy == SCHED_DEADLINE) {
+        struct sched_attr attr = {
+            .size = sizeof(attr),
+            .sched_policy = SCHED_DEADLINE,
+            .sched_runtime = t->wcet_ns,
+            .sched_deadline = t->period_ns,
+            .sched_period = t->period_ns,
+        };
+        return syscall(SYS_sched_setattr, 0, &attr, 0);
+    } else {
+        struct sched_param param = { .sched_priority = t->prio };
+        return pthread_setschedparam(pthread_self(), t->policy, &param);
+    }
+}
+
+static void *task_fn(void *arg)
+{
+    struct task_inst *inst = arg;
+    const struct task_desc *t = inst->desc;
+    struct timespec next = start_time;
+    struct rt_work_ctx work;
+    int err;
+
+    if (rt_work_init(&work, t->work) != 0) {
+        fprintf(stderr, "%s.%d: work init failed\n", t->name, inst->idx);
+        return NULL;
+    }
+
+    // 绑定 CPU
+    if (t->cpu >= 0) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(t->cpu, &mask);
+        if (sched_setaffinity(0, sizeof(mask), &mask) != 0)
+            perror("sched_setaffinity");
+    }
+
+    // 设置实时调度
+    err = set_sched(t);
+    if (err)
+        fprintf(stderr, "%s.%d: set scheduler: %s\n", t->name, inst->idx,
+                strerror(err > 0 ? err : errno));
+
+    // 设置任务期望 CPU 频率
+    if (t->freq && set_freq_hint(t->freq) != 0)
+        fprintf(stderr, "%s.%d: set freq hint: %s\n", t->name, inst->idx, strerror(errno));
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+    while (!stop) {
+        struct job_rec r;
+
+        r.release_ns = ts_to_ns(&next);
+        r.start_ns = now_ns();
+
+        rt_work_run(&work, t->work_units);
+
+        r.finish_ns = now_ns();
+        job_account(inst, &r);
+
+        // 高精度睡眠到下一个周期
+        ts_add_ns(&next, t->period_ns);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    rt_work_free(&work);
+    return NULL;
+}
+
+static void hist_print(const char *name, const struct hist *h)
+{
+    int i;
+
+    printf("    %-8s", name);
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        if (!h->b[i])
+            continue;
+        if (i == 0)
+            printf(" <1us:%llu", (unsigned long long)h->b[i]);
+        else if (i == HIST_BUCKETS - 1)
+            printf(" >=%lluus:%llu", 1ULL << (i - 1), (unsigned long long)h->b[i]);
+        else
+            printf(" %llu-%lluus:%llu", 1ULL << (i - 1), 1ULL << i,
+                   (unsigned long long)h->b[i]);
+    }
+    printf("\n");
+}
+
+// 退出后输出：汇总打印到 stdout，逐作业记录写入 <name>_<idx>.log
+static void dump_inst(const struct task_inst *inst)
+{
+    const struct task_desc *t = inst->desc;
+    const struct job_stats *st = &inst->st;
+    uint64_t first, j;
+    char path[64];
+    FILE *log;
+
+    printf("%s.%d: work=%s:%llu jobs=%llu misses=%llu", t->name, inst->idx,
+           rt_work_name(t->work), (unsigned long long)t->work_units,
+           (unsigned long long)st->jobs, (unsigned long long)st->misses);
+    if (st->jobs) {
+        printf(" resp_us min/avg/max=%.1f/%.1f/%.1f jitter_us avg/max=%.1f/%.1f max_lateness_us=%.1f",
+               st->resp_min / 1e3, (double)st->resp_sum / st->jobs / 1e3, st->resp_max / 1e3,
+               (double)st->jitter_sum / st->jobs / 1e3, st->jitter_max / 1e3, st->late_max / 1e3);
+    }
+    printf("\n");
+    hist_print("resp", &st->resp);
+    hist_print("jitter", &st->jitter);
+    hist_print("late", &st->late);
+    hist_print("slack", &st->slack);
+
+    snprintf(path, sizeof(path), "%s_%d.log", t->name, inst->idx);
+    log = fopen(path, "w");
+    if (!log) {
+        perror("log open");
+        return;
+    }
+    fprintf(log, "# job release_ns start_ns finish_ns response_ns lateness_ns\n");
+    first = st->jobs > inst->nrecs ? st->jobs - inst->nrecs : 0;
+    for (j = first; j < st->jobs; j++) {
+        const struct job_rec *r = &inst->recs[j % inst->nrecs];
+
+        fprintf(log, "%llu %llu %llu %llu %llu %lld\n",
+                (unsigned long long)j,
+                (unsigned long long)r->release_ns,
+                (unsigned long long)r->start_ns,
+                (unsigned long long)r->finish_ns,
+                (unsigned long long)(r->finish_ns - r->release_ns),
+                (long long)(r->finish_ns - r->release_ns - t->period_ns));
+    }
+    fclose(log);
+}
+
+// 在当前频率下标定各类负载，把 wcet_us 换算为固定工作量
+static int calibrate_work(void)
+{
+    double rate[WORK_KINDS] = { 0 };
+    int need[WORK_KINDS] = { 0 };
+    int i;
+
+    for (i = 0; i < ntasks; i++)
+        need[tasks[i].work] = 1;
+
+    if (need[WORK_CHASE] && rt_work_global_init() != 0) {
+        fprintf(stderr, "work: failed to build pointer-chase buffer\n");
+        return -1;
+    }
+
+    for (i = 0; i < WORK_KINDS; i++) {
+        if (!need[i])
+            continue;
+        rate[i] = rt_work_calibrate(i);
+        if (rate[i] <= 0.0) {
+            fprintf(stderr, "work: calibration of %s failed\n", rt_work_name(i));
+            return -1;
+        }
+        printf("calibrated %-8s %.2f units/us\n", rt_work_name(i), rate[i]);
+    }
+
+    for (i = 0; i < ntasks; i++) {
+        if (!tasks[i].work_units)
+            tasks[i].work_units = (uint64_t)(rate[tasks[i].work] * (tasks[i].wcet_ns / 1000.0));
+    }
+    return 0;
+}
+
+static struct rt_live_stats *live_stats_create(void)
+{
+    struct rt_live_stats *ls;
+    int fd;
+
+    fd = shm_open(RT_LIVE_SHM, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("shm_open " RT_LIVE_SHM);
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(*ls)) != 0) {
+        perror("ftruncate");
+        close(fd);
+        return NULL;
+    }
+    ls = mmap(NULL, sizeof(*ls), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ls == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    memset(ls, 0, sizeof(*ls));
+    ls->magic = RT_LIVE_MAGIC;
+    return ls;
+}
+
+int main(int argc, char *argv[])
+{
+    static struct task_inst insts[MAX_INSTS];
+    struct rt_live_stats *live;
+    int ninst = 0, duration = 0;
+    int i, j;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: sudo %s <taskset_file> [duration_s] [records_per_thread]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2)
+        duration = atoi(argv[2]);
+    if (argc > 3)
+        records_per_thread = strtoull(argv[3], NULL, 0);
+    if (!records_per_thread)
+        records_per_thread = DEFAULT_RECORDS;
+
+    if (load_taskset(argv[1]) != 0)
+        return 1;
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        perror("mlockall");
+
+    if (calibrate_work() != 0)
+        return 1;
+
+    live = live_stats_create();
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    // 所有线程在 100ms 后同步首次释放
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    ts_add_ns(&start_time, 100000000ULL);
+
+    for (i = 0; i < ntasks; i++) {
+        for (j = 0; j < tasks[i].count; j++) {
+            struct task_inst *inst;
+
+            if (ninst >= (int)(sizeof(insts) / sizeof(insts[0]))) {
+                fprintf(stderr, "too many task instances\n");
+                stop = 1;
+                goto join;
+            }
+            inst = &insts[ninst];
+            inst->desc = &tasks[i];
+            inst->idx = j;
+            inst->nrecs = records_per_thread;
+            if (live) {
+                inst->live = &live->s[ninst];
+                inst->live->period_ns = tasks[i].period_ns;
+                inst->live->cpu = tasks[i].cpu;
+                __atomic_store_n(&live->n, ninst + 1, __ATOMIC_RELEASE);
+            }
+            // 在 mlockall 之后分配并写零，保证 RT 循环内不会缺页
+            inst->recs = calloc(inst->nrecs, sizeof(*inst->recs));
+            if (!inst->recs) {
+                perror("calloc");
+                stop = 1;
+                goto join;
+            }
+            memset(inst->recs, 0, inst->nrecs * sizeof(*inst->recs));
+            if (pthread_create(&inst->tid, NULL, task_fn, inst) != 0) {
+                perror("pthread_create");
+                free(inst->recs);
+                stop = 1;
+                goto join;
+            }
+            ninst++;
+        }
+    }
+    printf("started %d threads from %d tasks\n", ninst, ntasks);
+
+    if (duration > 0) {
+        sleep(duration);
+        stop = 1;
+    } else {
+        while (!stop)
+            pause();
+    }
+
+join:
+    for (i = 0; i < ninst; i++)
+        pthread_join(insts[i].tid, NULL);
+    for (i = 0; i < ninst; i++) {
+        dump_inst(&insts[i]);
+        free(insts[i].recs);
+    }
+    rt_work_global_free();
+    if (live) {
+        munmap(live, sizeof(*live));
+        shm_unlink(RT_LIVE_SHM);
+    }
+    return 0;
+}
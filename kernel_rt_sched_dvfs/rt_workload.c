@@ -0,0 +1,225 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rt_workload.h"
+
+#define CACHELINE 64
+#define CHASE_BYTES  (32UL << 20)   // 远大于 LLC，保证追逐落到 DRAM
+#define STREAM_BYTES (8UL << 20)    // 每个 triad 数组
+#define CALIB_MIN_NS 20000000ULL    // 每种负载至少标定 20ms
+
+struct chase_node {
+    uint64_t next;
+    char pad[CACHELINE - sizeof(uint64_t)];
+};
+
+static struct chase_node *chase_buf;
+static uint64_t chase_nodes;
+static volatile uint64_t work_sink;     // 防止编译器删除计算结果
+
+static const char *work_names[WORK_KINDS] = { "spin", "compute", "chase", "stream" };
+
+const char *rt_work_name(enum rt_work_kind kind)
+{
+    return kind < WORK_KINDS ? work_names[kind] : "unknown";
+}
+
+int rt_work_parse(const char *s, enum rt_work_kind *kind, uint64_t *units)
+{
+    const char *colon = strchr(s, ':');
+    size_t len = colon ? (size_t)(colon - s) : strlen(s);
+    int i;
+
+    for (i = 0; i < WORK_KINDS; i++) {
+        if (strlen(work_names[i]) == len && !strncmp(s, work_names[i], len)) {
+            *kind = i;
+            *units = colon ? strtoull(colon + 1, NULL, 0) : 0;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int rt_work_global_init(void)
+{
+    uint64_t *perm;
+    uint64_t i;
+
+    chase_nodes = CHASE_BYTES / sizeof(struct chase_node);
+    chase_buf = aligned_alloc(CACHELINE, chase_nodes * sizeof(struct chase_node));
+    perm = malloc(chase_nodes * sizeof(*perm));
+    if (!chase_buf || !perm) {
+        free(chase_buf);
+        free(perm);
+        chase_buf = NULL;
+        return -1;
+    }
+
+    // 随机单环排列（Sattolo），让硬件预取无法预测下一跳
+    for (i = 0; i < chase_nodes; i++)
+        perm[i] = i;
+    srand(1);
+    for (i = chase_nodes - 1; i > 0; i--) {
+        uint64_t j = ((uint64_t)rand() * RAND_MAX + rand()) % i;
+        uint64_t tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    for (i = 0; i < chase_nodes; i++)
+        chase_buf[perm[i]].next = perm[(i + 1) % chase_nodes];
+
+    free(perm);
+    return 0;
+}
+
+void rt_work_global_free(void)
+{
+    free(chase_buf);
+    chase_buf = NULL;
+}
+
+int rt_work_init(struct rt_work_ctx *ctx, enum rt_work_kind kind)
+{
+    size_t n = STREAM_BYTES / sizeof(double);
+    size_t i;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->kind = kind;
+
+    if (kind == WORK_CHASE && !chase_buf)
+        return -1;
+
+    if (kind == WORK_STREAM) {
+        ctx->a = aligned_alloc(CACHELINE, STREAM_BYTES);
+        ctx->b = aligned_alloc(CACHELINE, STREAM_BYTES);
+        ctx->c = aligned_alloc(CACHELINE, STREAM_BYTES);
+        if (!ctx->a || !ctx->b || !ctx->c) {
+            rt_work_free(ctx);
+            return -1;
+        }
+        // 写入一遍以预先触发缺页
+        for (i = 0; i < n; i++) {
+            ctx->a[i] = 0.0;
+            ctx->b[i] = 1.0;
+            ctx->c[i] = 2.0;
+        }
+    }
+    return 0;
+}
+
+void rt_work_free(struct rt_work_ctx *ctx)
+{
+    free(ctx->a);
+    free(ctx->b);
+    free(ctx->c);
+    ctx->a = ctx->b = ctx->c = NULL;
+}
+
+void busy_work_ns(long ns) {
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1e9 + (now.tv_nsec - start.tv_nsec) < ns);
+}
+
+static void work_compute(uint64_t units)
+{
+    uint64_t x = 88172645463325252ULL;
+    double f = 1.0;
+    uint64_t i;
+
+    // 整数 xorshift 与浮点乘加两条依赖链交织，耗时与核心频率成正比
+    for (i = 0; i < units; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        f = f * 1.0000001 + (double)(x & 0xff) * 1e-9;
+    }
+    work_sink = x + (uint64_t)f;
+}
+
+static void work_chase(struct rt_work_ctx *ctx, uint64_t units)
+{
+    uint64_t p = ctx->chase_pos;
+    uint64_t i;
+
+    for (i = 0; i < units; i++)
+        p = chase_buf[p].next;
+    ctx->chase_pos = p;
+    work_sink = p;
+}
+
+static void work_stream(struct rt_work_ctx *ctx, uint64_t units)
+{
+    const size_t n = STREAM_BYTES / sizeof(double);
+    const size_t per_line = CACHELINE / sizeof(double);
+    size_t pos = ctx->stream_pos;
+    uint64_t i;
+    size_t k;
+
+    for (i = 0; i < units; i++) {
+        for (k = 0; k < per_line; k++)
+            ctx->a[pos + k] = ctx->b[pos + k] + 3.0 * ctx->c[pos + k];
+        pos += per_line;
+        if (pos >= n)
+            pos = 0;
+    }
+    ctx->stream_pos = pos;
+    work_sink = (uint64_t)ctx->a[0];
+}
+
+void rt_work_run(struct rt_work_ctx *ctx, uint64_t units)
+{
+    switch (ctx->kind) {
+    case WORK_SPIN:
+        busy_work_ns(units);
+        break;
+    case WORK_COMPUTE:
+        work_compute(units);
+        break;
+    case WORK_CHASE:
+        work_chase(ctx, units);
+        break;
+    case WORK_STREAM:
+        work_stream(ctx, units);
+        break;
+    default:
+        break;
+    }
+}
+
+double rt_work_calibrate(enum rt_work_kind kind)
+{
+    struct rt_work_ctx ctx;
+    uint64_t units = 1024, t0, dt;
+    double rate;
+
+    if (kind == WORK_SPIN)
+        return 1000.0;
+    if (rt_work_init(&ctx, kind) != 0)
+        return 0.0;
+
+    rt_work_run(&ctx, units);   // 预热
+    for (;;) {
+        t0 = now_ns();
+        rt_work_run(&ctx, units);
+        dt = now_ns() - t0;
+        if (dt >= CALIB_MIN_NS)
+            break;
+        units *= 2;
+    }
+    rate = (double)units * 1000.0 / dt;
+
+    rt_work_free(&ctx);
+    return rate;
+}
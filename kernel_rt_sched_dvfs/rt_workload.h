@@ -0,0 +1,44 @@
+#ifndef RT_WORKLOAD_H
+#define RT_WORKLOAD_H
+
+#include <stdint.h>
+
+// 固定工作量的负载核：执行时间随 CPU 频率（及访存特性）变化，
+// 而不是像 busy_work_ns() 那样按墙钟时间自旋
+enum rt_work_kind {
+    WORK_SPIN = 0,      // 原有按时间自旋，1 单位 = 1 ns
+    WORK_COMPUTE,       // 整数 + 浮点依赖链，1 单位 = 一轮迭代
+    WORK_CHASE,         // 随机指针追逐（访存延迟受限），1 单位 = 一次依赖访存
+    WORK_STREAM,        // 流式 triad（带宽受限），1 单位 = 一个 64 字节缓存行
+    WORK_KINDS,
+};
+
+// 每线程负载上下文，跨作业保留游标使连续作业继续向后访存
+struct rt_work_ctx {
+    enum rt_work_kind kind;
+    uint64_t chase_pos;
+    double *a, *b, *c;      // WORK_STREAM 私有数组
+    uint64_t stream_pos;    // 以 double 为单位
+};
+
+const char *rt_work_name(enum rt_work_kind kind);
+
+// 解析 "compute" 或 "compute:<units>"；未给出 units 时 *units = 0
+int rt_work_parse(const char *s, enum rt_work_kind *kind, uint64_t *units);
+
+// 进程级初始化（构建共享的指针追逐链），须在创建 RT 线程前调用
+int rt_work_global_init(void);
+void rt_work_global_free(void);
+
+int rt_work_init(struct rt_work_ctx *ctx, enum rt_work_kind kind);
+void rt_work_free(struct rt_work_ctx *ctx);
+
+// 执行固定工作量，可在 RT 循环内调用（不分配内存、不做系统调用）
+void rt_work_run(struct rt_work_ctx *ctx, uint64_t units);
+
+// 在当前 CPU、当前频率下标定：返回每微秒可完成的单位数
+double rt_work_calibrate(enum rt_work_kind kind);
+
+void busy_work_ns(long ns);
+
+#endif
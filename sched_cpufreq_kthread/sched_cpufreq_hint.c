@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#define DEVICE_PATH "/dev/sched_cpufreq"
+
+struct sched_cpufreq_hint {
+    int pid;                /* 0 = 调用线程自身 */
+    unsigned int freq;      /* kHz，0 = 清除提示 */
+};
+
+#define IOCTL_SET_HINT _IOW('s', 1, struct sched_cpufreq_hint)
+#define IOCTL_GET_HINT _IOWR('s', 2, struct sched_cpufreq_hint)
+
+int main(int argc, char *argv[])
+{
+    int fd;
+    struct sched_cpufreq_hint data;
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: sudo %s <pid> [freq_khz]\n", argv[0]);
+        fprintf(stderr, "  without freq_khz: query; freq_khz=0: clear\n");
+        return 1;
+    }
+
+    data.pid = atoi(argv[1]);
+    data.freq = argc == 3 ? (unsigned int)strtoul(argv[2], NULL, 0) : 0;
+
+    fd = open(DEVICE_PATH, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        return 1;
+    }
+
+    if (ioctl(fd, argc == 3 ? IOCTL_SET_HINT : IOCTL_GET_HINT, &data) < 0) {
+        perror("ioctl");
+        close(fd);
+        return 1;
+    }
+
+    printf("pid %d: cpufreq hint %u kHz\n", data.pid, data.freq);
+
+    close(fd);
+    return 0;
+}
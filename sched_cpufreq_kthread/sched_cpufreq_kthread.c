@@ -9,27 +9,211 @@
 #include <linux/irq_work.h>
 #include <linux/atomic.h>
 #include <linux/notifier.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/hashtable.h>
+#include <linux/rculist.h>
+#include <linux/slab.h>
+#include <linux/fs.h>
+#include <linux/cdev.h>
+#include <linux/device.h>
+#include <linux/uaccess.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/version.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/sched/task.h>
+#include <linux/workqueue.h>
+#include <linux/tracepoint.h>
+
+#define CREATE_TRACE_POINTS
+#include "sched_cpufreq_trace.h"
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("zs");
-MODULE_DESCRIPTION("RT Task CPUFreq Control via exported notifier + kthread");
+MODULE_DESCRIPTION("RT Task CPUFreq Control via sched switch hook + kthread");
 MODULE_VERSION("1.0");
 
 /* --- 模块状态 --- */
+#define FREQ_TARGET_CPU 0       /* 调频线程修改的 CPU */
+
 static unsigned int target_freq = 0;
+static int target_src;          /* 最近一次请求的来源 DVFS_SRC_* */
+static u64 target_req_ns;       /* 最近一次请求的时间 */
+static u64 inflight_ns;         /* 调频线程正在执行的请求时间，0 = 无 */
+static int inflight_src;
 static atomic_t freq_pending;
 static struct irq_work freq_irq_work;
 static struct task_struct *freq_kthread;
 
+/* --- 预测模式参数 --- */
+static bool predict;
+module_param(predict, bool, 0644);
+MODULE_PARM_DESC(predict, "Raise frequency before the predicted next activation of periodic RT tasks");
+
+static unsigned int lead_us = 500;
+module_param(lead_us, uint, 0644);
+MODULE_PARM_DESC(lead_us, "How long (us) before the predicted wakeup the frequency is raised");
+
+static unsigned int tol_us = 200;
+module_param(tol_us, uint, 0644);
+MODULE_PARM_DESC(tol_us, "Max |actual - predicted| activation error (us) counted as a hit");
+
+#define PRED_SLOTS 16
+#define PRED_PROC_NAME "sched_cpufreq_pred"
+
+/* --- 每个 RT 任务的周期预测记录 --- */
+struct pred_entry {
+    pid_t pid;                  /* 0 = 空槽 */
+    char comm[TASK_COMM_LEN];
+    unsigned int freq;          /* 任务请求的频率 (kHz) */
+    unsigned long nvcsw;        /* 上次激活时的 nvcsw，用于区分新激活与抢占后恢复 */
+    u64 last_act_ns;            /* 上次激活时间 */
+    u64 period_ns;              /* 学习到的激活周期 */
+    u64 expected_ns;            /* 预测的下次激活时间，0 = 未布防 */
+    s64 last_err_ns;            /* 最近一次 实际 - 预测 */
+    unsigned long activations;
+    unsigned long hits;
+    unsigned long misses;
+    struct hrtimer timer;       /* 在 expected_ns - lead 时刻触发预调频 */
+};
+
+static struct pred_entry pred_tbl[PRED_SLOTS];
+static DEFINE_RAW_SPINLOCK(pred_lock);
+
+/* --- 模块侧频率提示表：按 pid 哈希，读侧 RCU 无锁 --- */
+#define HINT_HASH_BITS 8
+
+/* 用户态与模块共享的每线程结构（类似 rseq）：注册一次，之后改提示只需一次普通写 */
+struct sched_cpufreq_shm {
+    __u32 version;          /* 用户填 SCHED_CPUFREQ_SHM_VERSION */
+    __u32 freq;             /* kHz，用户态随时写，0 = 无提示 */
+    __u32 applied;          /* 内核写：最近一次切入时采用的频率 */
+    __u32 switches;         /* 内核写：读取该结构的切入次数 */
+} __aligned(16);
+
+#define SCHED_CPUFREQ_SHM_VERSION 1
+
+/* 一次注册：被 pin 住的用户页及其内核映射 */
+struct hint_shm {
+    struct sched_cpufreq_shm *kaddr;
+    struct page *page;
+    void *map;
+    struct file *owner;     /* 注册所用的 fd，关闭时自动注销 */
+    struct task_struct *task;   /* 注册线程（持有引用）；只有它切入时才读写共享结构 */
+    struct hint_shm *free_next;
+};
+
+struct freq_hint {
+    pid_t pid;
+    unsigned int freq;              /* ioctl 设置的静态提示 */
+    struct hint_shm __rcu *shm;     /* 非空时优先读取共享结构中的提示 */
+    struct hlist_node node;
+    struct rcu_head rcu;
+};
+
+static DEFINE_HASHTABLE(hint_tbl, HINT_HASH_BITS);
+static DEFINE_SPINLOCK(hint_lock);      /* 仅写者使用 */
+static struct hint_shm *hint_shm_dead;  /* 线程退出时摘下、等待回收的注册，由 hint_lock 保护 */
+
+/* --- 用户接口：/dev/sched_cpufreq ioctl --- */
+#define DEVICE_NAME "sched_cpufreq"
+#define CLASS_NAME  "sched_cpufreq"
+
+struct sched_cpufreq_hint {
+    int pid;                /* 0 = 调用线程自身 */
+    unsigned int freq;      /* kHz，0 = 清除提示 */
+};
+
+#define IOCTL_SET_HINT _IOW('s', 1, struct sched_cpufreq_hint)
+#define IOCTL_GET_HINT _IOWR('s', 2, struct sched_cpufreq_hint)
+#define IOCTL_SHM_REGISTER   _IOW('s', 3, struct sched_cpufreq_shm)
+#define IOCTL_SHM_UNREGISTER _IO('s', 4)
+
+static struct class *hint_class;
+static struct cdev hint_cdev;
+static dev_t hint_devt;
+
+/* --- 每任务频率驻留统计 --- */
+static bool acct = false;
+static int acct_param_set(const char *val, const struct kernel_param *kp);
+static const struct kernel_param_ops acct_param_ops = {
+    .set = acct_param_set,
+    .get = param_get_bool,
+};
+module_param_cb(acct, &acct_param_ops, &acct, 0644);
+MODULE_PARM_DESC(acct, "Account RT task run time per frequency step (needs the cpufreq transition notifier)");
+
+#define ACCT_SLOTS 32
+#define ACCT_STEPS 16
+#define ACCT_PROC_NAME "sched_cpufreq_acct"
+
+struct acct_step {
+    unsigned int freq;          /* kHz，0 = 空 */
+    u64 ns;
+};
+
+struct acct_entry {
+    raw_spinlock_t lock;        /* 保护本槽位的全部字段 */
+    int active;                 /* 正在为该槽计时的 CPU 数，>0 时不可被复用 */
+    pid_t pid;                  /* 0 = 空槽 */
+    char comm[TASK_COMM_LEN];
+    unsigned int req_freq;      /* 最近一次请求的频率 */
+    u64 last_seen_ns;
+    u64 total_ns;
+    u64 below_ns;               /* 运行频率低于请求频率的时间 */
+    u64 other_ns;               /* steps[] 已满时落入此处 */
+    struct acct_step steps[ACCT_STEPS];
+};
+
+/* 每 CPU 当前正在计时的运行段，由本 CPU 的 lock 保护（频率切换回调会跨 CPU 访问） */
+struct acct_cpu {
+    raw_spinlock_t lock;
+    struct acct_entry *cur;     /* NULL = 当前任务不计 */
+    u64 since_ns;
+    unsigned int cur_freq;      /* 该 CPU 当前实际频率，由 transition notifier 维护 */
+};
+
+static struct acct_entry acct_tbl[ACCT_SLOTS];
+static DEFINE_PER_CPU(struct acct_cpu, acct_cpu);
+/*
+ * 锁顺序：acct_cpu.lock -> acct_alloc_lock -> acct_entry.lock，同一时刻最多持有一个槽锁。
+ * 切换热路径只取本 CPU 的锁和命中槽位的锁；acct_alloc_lock 只在任务第一次出现（分配槽位）时使用。
+ */
+static DEFINE_RAW_SPINLOCK(acct_alloc_lock);
+
+#ifndef SCHED_CPUFREQ_TRACEPOINT
 /* --- 外部内核符号 --- */
 extern struct raw_notifier_head cpufreq_task_switch_notifier;
+#endif
+
+/* --- 提交调频请求，由 kthread 异步执行 --- */
+static void request_freq(unsigned int freq, int src)
+{
+    u64 now = ktime_get_ns();
+
+    trace_dvfs_freq_request(FREQ_TARGET_CPU,
+                            READ_ONCE(per_cpu_ptr(&acct_cpu, FREQ_TARGET_CPU)->cur_freq),
+                            freq, src);
+    WRITE_ONCE(target_src, src);
+    WRITE_ONCE(target_req_ns, now);
+    WRITE_ONCE(target_freq, freq);
+    atomic_set(&freq_pending, 1);
+    irq_work_queue(&freq_irq_work);
+}
 
 /* --- 调频线程: CPU1 修改 CPU0 --- */
 static int freq_thread_fn(void *data)
 {
-    int cpu_target = 0;
+    int cpu_target = FREQ_TARGET_CPU;
     struct cpufreq_policy *policy;
-    unsigned int freq;
+    unsigned int freq, old_freq;
+    u64 req_ns;
+    int src, ret;
 
     pr_info("freq_thread running on CPU%d (target CPU%d)\n",
             smp_processor_id(), cpu_target);
@@ -45,11 +229,19 @@ static int freq_thread_fn(void *data)
         __set_current_state(TASK_RUNNING);
         atomic_set(&freq_pending, 0);
 
-        freq = target_freq;
+        freq = READ_ONCE(target_freq);
+        src = READ_ONCE(target_src);
+        req_ns = READ_ONCE(target_req_ns);
         policy = cpufreq_cpu_get(cpu_target);
         if (policy) {
-            pr_info("Updating CPU%d freq to %u kHz\n", cpu_target, freq);
-            cpufreq_driver_target(policy, freq, CPUFREQ_RELATION_L);
+            old_freq = policy->cur;
+            /* 供 transition notifier 把随后的 POSTCHANGE 归到本次请求 */
+            WRITE_ONCE(inflight_src, src);
+            WRITE_ONCE(inflight_ns, req_ns);
+            ret = cpufreq_driver_target(policy, freq, CPUFREQ_RELATION_L);
+            WRITE_ONCE(inflight_ns, 0);
+            trace_dvfs_freq_apply(cpu_target, old_freq, policy->cur, src,
+                                  ktime_get_ns() - req_ns, ret);
             cpufreq_cpu_put(policy);
         } else {
             pr_warn("CPU%d: no cpufreq policy found\n", cpu_target);
@@ -67,20 +259,784 @@ static void freq_irq_work_func(struct irq_work *work)
         wake_up_process(freq_kthread);
 }
 
-/* --- Notifier 回调 --- */
-static int cpufreq_task_switch_cb(struct notifier_block *nb,
-                                  unsigned long val, void *data)
+/* 调用者处于 RCU 读侧 */
+static struct freq_hint *hint_find_rcu(pid_t pid)
+{
+    struct freq_hint *h;
+
+    hash_for_each_possible_rcu(hint_tbl, h, node, pid) {
+        if (h->pid == pid)
+            return h;
+    }
+    return NULL;
+}
+
+/*
+ * 注册属于 p 时共享结构才有效；p 为 NULL（按 pid 查询）时要求注册线程尚未退出。
+ * pid 被复用后，新任务与注册线程的 task_struct 不同，不会读到或写入旧线程的页。
+ */
+static bool hint_shm_valid(const struct hint_shm *shm, const struct task_struct *p)
+{
+    return p ? shm->task == p : !(READ_ONCE(shm->task->flags) & PF_EXITING);
+}
+
+/* 共享结构中的提示优先，其次是 ioctl 设置的静态提示 */
+static unsigned int hint_entry_freq(struct freq_hint *h, struct task_struct *p, bool on_switch)
+{
+    struct hint_shm *shm = rcu_dereference(h->shm);
+    unsigned int freq = 0;
+
+    if (shm && hint_shm_valid(shm, p)) {
+        freq = READ_ONCE(shm->kaddr->freq);
+        if (on_switch) {
+            WRITE_ONCE(shm->kaddr->applied, freq);
+            WRITE_ONCE(shm->kaddr->switches, shm->kaddr->switches + 1);
+        }
+    }
+    if (!freq)
+        freq = READ_ONCE(h->freq);
+    return freq;
+}
+
+/* 热路径查找：调度器上下文中调用，不取锁。p 为切入的任务，ioctl 查询时为 NULL */
+static unsigned int hint_lookup(pid_t pid, struct task_struct *p, bool on_switch)
+{
+    struct freq_hint *h;
+    unsigned int freq = 0;
+
+    rcu_read_lock();
+    h = hint_find_rcu(pid);
+    if (h)
+        freq = hint_entry_freq(h, p, on_switch);
+    rcu_read_unlock();
+    return freq;
+}
+
+static int hint_set(pid_t pid, unsigned int freq)
+{
+    struct freq_hint *h, *new = NULL;
+
+    if (freq) {
+        new = kmalloc(sizeof(*new), GFP_KERNEL);
+        if (!new)
+            return -ENOMEM;
+        new->pid = pid;
+        new->freq = freq;
+    }
+
+    spin_lock(&hint_lock);
+    hash_for_each_possible(hint_tbl, h, node, pid) {
+        if (h->pid != pid)
+            continue;
+        WRITE_ONCE(h->freq, freq);
+        /* 仍有共享结构注册时保留条目 */
+        if (!freq && !rcu_access_pointer(h->shm)) {
+            hash_del_rcu(&h->node);
+            kfree_rcu(h, rcu);
+        }
+        goto out;
+    }
+    if (new) {
+        hash_add_rcu(hint_tbl, &new->node, pid);
+        new = NULL;
+    }
+out:
+    spin_unlock(&hint_lock);
+    kfree(new);
+    return 0;
+}
+
+/* 解除映射并释放一串注册，调用前须已过一个 RCU 宽限期 */
+static void hint_shm_free_list(struct hint_shm *list)
+{
+    struct hint_shm *shm;
+
+    while (list) {
+        shm = list;
+        list = shm->free_next;
+        vunmap(shm->map);
+        unpin_user_page(shm->page);
+        put_task_struct(shm->task);
+        kfree(shm);
+    }
+}
+
+/* 回收线程退出时摘下的注册：tracepoint 回调不能睡眠，宽限期与解除映射放到 workqueue */
+static void hint_shm_reap(struct work_struct *work)
+{
+    struct hint_shm *list;
+
+    spin_lock(&hint_lock);
+    list = hint_shm_dead;
+    hint_shm_dead = NULL;
+    spin_unlock(&hint_lock);
+
+    if (!list)
+        return;
+    synchronize_rcu();
+    hint_shm_free_list(list);
+}
+
+static DECLARE_WORK(hint_shm_reap_work, hint_shm_reap);
+
+/* 从条目上摘下共享结构，条目不再有静态提示时一并删除。调用者持有 hint_lock */
+static struct hint_shm *hint_shm_detach(struct freq_hint *h)
+{
+    struct hint_shm *shm = rcu_dereference_protected(h->shm, lockdep_is_held(&hint_lock));
+
+    RCU_INIT_POINTER(h->shm, NULL);
+    if (!h->freq) {
+        hash_del_rcu(&h->node);
+        kfree_rcu(h, rcu);
+    }
+    return shm;
+}
+
+/* --- 共享结构注册：pin 住用户页并建立内核映射，调度路径无需访问用户地址 --- */
+static int hint_shm_register(struct file *file, unsigned long uaddr)
+{
+    struct sched_cpufreq_shm __user *ushm = (void __user *)uaddr;
+    pid_t pid = task_pid_nr(current);
+    struct freq_hint *h, *new;
+    struct hint_shm *shm, *old = NULL;
+    u32 version;
+    int ret;
+
+    /* 按结构大小对齐，保证不跨页 */
+    if (!IS_ALIGNED(uaddr, sizeof(struct sched_cpufreq_shm)))
+        return -EINVAL;
+    if (get_user(version, &ushm->version))
+        return -EFAULT;
+    if (version != SCHED_CPUFREQ_SHM_VERSION)
+        return -EINVAL;
+
+    shm = kzalloc(sizeof(*shm), GFP_KERNEL);
+    new = kzalloc(sizeof(*new), GFP_KERNEL);
+    if (!shm || !new) {
+        ret = -ENOMEM;
+        goto err_free;
+    }
+
+    ret = pin_user_pages_fast(uaddr & PAGE_MASK, 1, FOLL_WRITE | FOLL_LONGTERM, &shm->page);
+    if (ret != 1) {
+        ret = ret < 0 ? ret : -EFAULT;
+        goto err_free;
+    }
+    shm->map = vmap(&shm->page, 1, VM_MAP, PAGE_KERNEL);
+    if (!shm->map) {
+        ret = -ENOMEM;
+        goto err_unpin;
+    }
+    shm->kaddr = shm->map + offset_in_page(uaddr);
+    shm->owner = file;
+    shm->task = get_task_struct(current);
+
+    spin_lock(&hint_lock);
+    h = NULL;
+    hash_for_each_possible(hint_tbl, h, node, pid) {
+        if (h->pid == pid)
+            break;
+    }
+    if (h && rcu_access_pointer(h->shm)) {
+        old = rcu_dereference_protected(h->shm, lockdep_is_held(&hint_lock));
+        if (old->task == current) {
+            spin_unlock(&hint_lock);
+            put_task_struct(shm->task);
+            ret = -EBUSY;
+            goto err_unmap;
+        }
+        /* pid 被复用：旧注册属于已退出的线程（退出回调没有摘掉它时），直接替换 */
+    }
+    if (!h) {
+        new->pid = pid;
+        hash_add_rcu(hint_tbl, &new->node, pid);
+        h = new;
+        new = NULL;
+    }
+    rcu_assign_pointer(h->shm, shm);
+    spin_unlock(&hint_lock);
+
+    kfree(new);
+    if (old) {
+        old->free_next = NULL;
+        synchronize_rcu();
+        hint_shm_free_list(old);
+    }
+    return 0;
+
+err_unmap:
+    vunmap(shm->map);
+err_unpin:
+    unpin_user_page(shm->page);
+err_free:
+    kfree(new);
+    kfree(shm);
+    return ret;
+}
+
+/*
+ * 注销匹配的注册：owner 非空时匹配该 fd 的全部注册，否则匹配注册线程 task。
+ * 先摘下指针，等一个宽限期确认调度路径不再引用后再解除映射。
+ */
+static int hint_shm_drop(struct file *owner, struct task_struct *task)
+{
+    struct hint_shm *shm, *free_list = NULL;
+    struct freq_hint *h;
+    struct hlist_node *tmp;
+    int bkt;
+
+    spin_lock(&hint_lock);
+    hash_for_each_safe(hint_tbl, bkt, tmp, h, node) {
+        shm = rcu_dereference_protected(h->shm, lockdep_is_held(&hint_lock));
+        if (!shm || (owner ? shm->owner != owner : shm->task != task))
+            continue;
+
+        hint_shm_detach(h);
+        shm->free_next = free_list;
+        free_list = shm;
+    }
+    spin_unlock(&hint_lock);
+
+    if (!free_list)
+        return -ENOENT;
+
+    synchronize_rcu();
+    hint_shm_free_list(free_list);
+    return 0;
+}
+
+/*
+ * sched_process_exit：线程退出时注销它的共享结构注册（与 rseq 一致），
+ * 即使注册所用的 fd 仍由进程内其它线程持有。回调不能睡眠，回收交给 workqueue。
+ */
+static struct tracepoint *sched_exit_tp;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 16, 0)
+static void probe_sched_process_exit(void *data, struct task_struct *p, bool group_dead)
+#else
+static void probe_sched_process_exit(void *data, struct task_struct *p)
+#endif
+{
+    struct freq_hint *h;
+    struct hint_shm *shm;
+    bool mine;
+
+    /* 绝大多数退出的任务没有注册，先在 RCU 读侧确认，避免每次退出都取锁 */
+    rcu_read_lock();
+    h = hint_find_rcu(p->pid);
+    shm = h ? rcu_dereference(h->shm) : NULL;
+    mine = shm && shm->task == p;
+    rcu_read_unlock();
+    if (!mine)
+        return;
+
+    spin_lock(&hint_lock);
+    hash_for_each_possible(hint_tbl, h, node, p->pid) {
+        shm = rcu_dereference_protected(h->shm, lockdep_is_held(&hint_lock));
+        if (h->pid != p->pid || !shm || shm->task != p)
+            continue;
+        hint_shm_detach(h);
+        shm->free_next = hint_shm_dead;
+        hint_shm_dead = shm;
+        break;
+    }
+    spin_unlock(&hint_lock);
+    schedule_work(&hint_shm_reap_work);
+}
+
+static void find_sched_exit(struct tracepoint *tp, void *priv)
+{
+    if (!strcmp(tp->name, "sched_process_exit"))
+        sched_exit_tp = tp;
+}
+
+/* 找不到 tracepoint 时不致命：已退出线程的注册在切换路径上被忽略，直到 fd 关闭或 pid 复用时替换 */
+static void exit_hook_register(void)
+{
+    for_each_kernel_tracepoint(find_sched_exit, NULL);
+    if (!sched_exit_tp || tracepoint_probe_register(sched_exit_tp, probe_sched_process_exit, NULL)) {
+        pr_warn("sched_process_exit tracepoint unavailable, stale shm registrations are reaped lazily\n");
+        sched_exit_tp = NULL;
+    }
+}
+
+static void exit_hook_unregister(void)
+{
+    if (sched_exit_tp) {
+        tracepoint_probe_unregister(sched_exit_tp, probe_sched_process_exit, NULL);
+        tracepoint_synchronize_unregister();
+    }
+    flush_work(&hint_shm_reap_work);
+}
+
+static void hint_clear_all(void)
+{
+    struct freq_hint *h;
+    struct hlist_node *tmp;
+    int bkt;
+
+    spin_lock(&hint_lock);
+    hash_for_each_safe(hint_tbl, bkt, tmp, h, node) {
+        /* 带共享结构的条目已在 fd 关闭时注销，这里只剩静态提示 */
+        hash_del_rcu(&h->node);
+        kfree_rcu(h, rcu);
+    }
+    spin_unlock(&hint_lock);
+}
+
+/* 模块提示表优先；打补丁的内核上回退到 task_struct->cpufreq */
+static unsigned int task_freq_hint(struct task_struct *p)
+{
+    unsigned int freq = hint_lookup(p->pid, p, true);
+
+#ifndef SCHED_CPUFREQ_TRACEPOINT
+    if (!freq)
+        freq = p->cpufreq;
+#endif
+    return freq;
+}
+
+/* --- 预调频定时器回调（硬中断上下文） --- */
+static enum hrtimer_restart pred_timer_fn(struct hrtimer *timer)
+{
+    struct pred_entry *e = container_of(timer, struct pred_entry, timer);
+
+    request_freq(READ_ONCE(e->freq), DVFS_SRC_PREDICT);
+    return HRTIMER_NORESTART;
+}
+
+/* 查找 pid 对应槽位；不存在时复用空槽或最久未激活的槽。调用者持有 pred_lock */
+static struct pred_entry *pred_find(struct task_struct *p)
+{
+    struct pred_entry *victim = &pred_tbl[0];
+    int i;
+
+    for (i = 0; i < PRED_SLOTS; i++) {
+        if (pred_tbl[i].pid == p->pid)
+            return &pred_tbl[i];
+        if (pred_tbl[i].last_act_ns < victim->last_act_ns)
+            victim = &pred_tbl[i];
+    }
+
+    hrtimer_try_to_cancel(&victim->timer);
+    victim->pid = p->pid;
+    memcpy(victim->comm, p->comm, TASK_COMM_LEN);
+    victim->nvcsw = 0;
+    victim->last_act_ns = 0;
+    victim->period_ns = 0;
+    victim->expected_ns = 0;
+    victim->last_err_ns = 0;
+    victim->activations = 0;
+    victim->hits = 0;
+    victim->misses = 0;
+    return victim;
+}
+
+/* --- 学习激活周期并布防下一次预调频 --- */
+static void pred_on_switch(struct task_struct *next, unsigned int freq)
+{
+    u64 now = ktime_get_ns();
+    u64 lead_ns = (u64)READ_ONCE(lead_us) * NSEC_PER_USEC;
+    u64 tol_ns = (u64)READ_ONCE(tol_us) * NSEC_PER_USEC;
+    struct pred_entry *e;
+    unsigned long flags;
+
+    raw_spin_lock_irqsave(&pred_lock, flags);
+    e = pred_find(next);
+    WRITE_ONCE(e->freq, freq);
+
+    /* nvcsw 未变说明任务是被抢占后恢复，而不是睡眠后的新一次激活 */
+    if (e->last_act_ns && next->nvcsw == e->nvcsw)
+        goto out;
+    e->nvcsw = next->nvcsw;
+    e->activations++;
+
+    if (e->expected_ns) {
+        e->last_err_ns = (s64)(now - e->expected_ns);
+        if (abs(e->last_err_ns) <= tol_ns)
+            e->hits++;
+        else
+            e->misses++;
+        e->expected_ns = 0;
+    }
+
+    if (e->last_act_ns) {
+        u64 delta = now - e->last_act_ns;
+
+        /* 首个样本直接采用，之后按 1/8 EWMA 平滑 */
+        if (e->period_ns)
+            e->period_ns = e->period_ns - (e->period_ns >> 3) + (delta >> 3);
+        else
+            e->period_ns = delta;
+    }
+    e->last_act_ns = now;
+
+    if (e->period_ns > lead_ns) {
+        e->expected_ns = now + e->period_ns;
+        hrtimer_start(&e->timer, ns_to_ktime(e->expected_ns - lead_ns),
+                      HRTIMER_MODE_ABS_HARD);
+    }
+out:
+    raw_spin_unlock_irqrestore(&pred_lock, flags);
+}
+
+/* 在表中查找 pid 并占用该槽（active++），调用者持有本 CPU 的 acct_cpu.lock */
+static struct acct_entry *acct_lookup_get(pid_t pid)
+{
+    int i;
+
+    for (i = 0; i < ACCT_SLOTS; i++) {
+        struct acct_entry *e = &acct_tbl[i];
+
+        if (READ_ONCE(e->pid) != pid)
+            continue;
+        /* 加锁后复查，槽位可能刚被其它 CPU 复用 */
+        raw_spin_lock(&e->lock);
+        if (e->pid == pid) {
+            e->active++;
+            raw_spin_unlock(&e->lock);
+            return e;
+        }
+        raw_spin_unlock(&e->lock);
+    }
+    return NULL;
+}
+
+/*
+ * 查找或分配统计槽位并占用它。表满时复用最久未运行、且没有任何 CPU 正在为其计时的槽；
+ * 所有槽都在计时中时返回 NULL，本段运行不计。调用者持有本 CPU 的 acct_cpu.lock。
+ */
+static struct acct_entry *acct_get(struct task_struct *p)
 {
-    struct task_struct *next = data;
+    struct acct_entry *e;
+    int i, tries;
+
+    e = acct_lookup_get(p->pid);
+    if (e)
+        return e;
+
+    raw_spin_lock(&acct_alloc_lock);
+    /* 持有 acct_alloc_lock 后复查，避免两个 CPU 为同一任务各分配一个槽 */
+    e = acct_lookup_get(p->pid);
+    if (e)
+        goto out;
+
+    for (tries = 0; tries < ACCT_SLOTS; tries++) {
+        struct acct_entry *victim = NULL;
+
+        for (i = 0; i < ACCT_SLOTS; i++) {
+            struct acct_entry *c = &acct_tbl[i];
+
+            if (READ_ONCE(c->active))
+                continue;
+            if (!victim || READ_ONCE(c->last_seen_ns) < READ_ONCE(victim->last_seen_ns))
+                victim = c;
+        }
+        if (!victim)
+            break;
+
+        raw_spin_lock(&victim->lock);
+        if (victim->active) {
+            /* 扫描之后被其它 CPU 占用了，重新挑选 */
+            raw_spin_unlock(&victim->lock);
+            continue;
+        }
+        memset(&victim->pid, 0, sizeof(*victim) - offsetof(struct acct_entry, pid));
+        victim->pid = p->pid;
+        memcpy(victim->comm, p->comm, TASK_COMM_LEN);
+        victim->active = 1;
+        raw_spin_unlock(&victim->lock);
+        e = victim;
+        break;
+    }
+out:
+    raw_spin_unlock(&acct_alloc_lock);
+    return e;
+}
+
+static void acct_put(struct acct_entry *e)
+{
+    raw_spin_lock(&e->lock);
+    e->active--;
+    raw_spin_unlock(&e->lock);
+}
+
+/* 把 [since_ns, now) 这段运行时间记到 ac->cur 上，调用者持有 ac->lock */
+static void acct_close(struct acct_cpu *ac, u64 now)
+{
+    struct acct_entry *e = ac->cur;
+    u64 delta = now - ac->since_ns;
+    int i;
+
+    if (!e)
+        return;
+
+    raw_spin_lock(&e->lock);
+    e->total_ns += delta;
+    e->last_seen_ns = now;
+    if (ac->cur_freq < e->req_freq)
+        e->below_ns += delta;
+
+    for (i = 0; i < ACCT_STEPS; i++) {
+        if (e->steps[i].freq == ac->cur_freq || !e->steps[i].freq) {
+            e->steps[i].freq = ac->cur_freq;
+            e->steps[i].ns += delta;
+            goto out;
+        }
+    }
+    e->other_ns += delta;
+out:
+    raw_spin_unlock(&e->lock);
+}
+
+/* 每次切换都调用：结束本 CPU 上一段计时，若 next 带提示则开始新的一段 */
+static void acct_on_switch(struct task_struct *next, unsigned int freq)
+{
+    struct acct_cpu *ac;
+    struct acct_entry *e;
+    unsigned long flags;
+    u64 now;
+
+    ac = this_cpu_ptr(&acct_cpu);
+    if (!READ_ONCE(ac->cur) && !freq)
+        return;
+
+    now = ktime_get_ns();
+    raw_spin_lock_irqsave(&ac->lock, flags);
+    acct_close(ac, now);
+    if (ac->cur)
+        acct_put(ac->cur);
+    ac->cur = NULL;
+    if (freq) {
+        e = acct_get(next);
+        if (e) {
+            raw_spin_lock(&e->lock);
+            e->req_freq = freq;
+            raw_spin_unlock(&e->lock);
+            ac->cur = e;
+            ac->since_ns = now;
+        }
+    }
+    raw_spin_unlock_irqrestore(&ac->lock, flags);
+}
+
+/* 频率切换完成后，在切换点拆分各 CPU 的运行段，并记录切换完成事件 */
+static int acct_transition_cb(struct notifier_block *nb,
+                              unsigned long val, void *data)
+{
+    struct cpufreq_freqs *freqs = data;
+    unsigned long flags;
+    u64 now, req_ns;
+    int cpu;
+
+    if (val != CPUFREQ_POSTCHANGE)
+        return NOTIFY_OK;
+
+    now = ktime_get_ns();
+    req_ns = READ_ONCE(inflight_ns);
+    if (req_ns && cpumask_test_cpu(FREQ_TARGET_CPU, freqs->policy->cpus))
+        trace_dvfs_freq_complete(freqs->policy->cpu, freqs->old, freqs->new,
+                                 READ_ONCE(inflight_src), now - req_ns, 0);
+    else
+        trace_dvfs_freq_complete(freqs->policy->cpu, freqs->old, freqs->new,
+                                 DVFS_SRC_OTHER, 0, 0);
+
+    for_each_cpu(cpu, freqs->policy->cpus) {
+        struct acct_cpu *ac = per_cpu_ptr(&acct_cpu, cpu);
+
+        raw_spin_lock_irqsave(&ac->lock, flags);
+        acct_close(ac, now);
+        ac->since_ns = now;
+        WRITE_ONCE(ac->cur_freq, freqs->new);
+        raw_spin_unlock_irqrestore(&ac->lock, flags);
+    }
+    return NOTIFY_OK;
+}
+
+static struct notifier_block acct_transition_nb = {
+    .notifier_call = acct_transition_cb,
+};
+
+/*
+ * transition notifier 按需注册：只在 acct 打开或 dvfs_freq_complete 事件启用时挂上。
+ * 任一 policy 已开启 fast switch 时内核拒绝注册（-EBUSY），注册期间 schedutil 也无法开启 fast switch，
+ * 所以默认不注册，注册失败只让统计/事件不可用，不影响模块加载。
+ */
+static DEFINE_MUTEX(transition_lock);
+static unsigned int transition_users;   /* acct 与 dvfs_freq_complete 各算一个 */
+static bool transition_ready;           /* 模块初始化完成后才真正注册 */
+static bool transition_registered;
+
+static int transition_sync(void)
+{
+    bool want = transition_ready && transition_users;
+    int cpu, ret;
+
+    lockdep_assert_held(&transition_lock);
+    if (want == transition_registered)
+        return 0;
+    if (!want) {
+        cpufreq_unregister_notifier(&acct_transition_nb, CPUFREQ_TRANSITION_NOTIFIER);
+        transition_registered = false;
+        return 0;
+    }
+
+    ret = cpufreq_register_notifier(&acct_transition_nb, CPUFREQ_TRANSITION_NOTIFIER);
+    if (ret) {
+        pr_warn("cpufreq transition notifier unavailable (%d)%s\n", ret,
+                ret == -EBUSY ? ": a policy uses fast switch" : "");
+        return ret;
+    }
+    transition_registered = true;
+    /* 未注册期间错过的切换不会再通知，重新取一次各 CPU 当前频率 */
+    for_each_possible_cpu(cpu)
+        WRITE_ONCE(per_cpu_ptr(&acct_cpu, cpu)->cur_freq, cpufreq_quick_get(cpu));
+    return 0;
+}
+
+static int transition_get(void)
+{
+    int ret;
+
+    transition_users++;
+    ret = transition_sync();
+    if (ret)
+        transition_users--;
+    return ret;
+}
+
+static void transition_put(void)
+{
+    transition_users--;
+    transition_sync();
+}
+
+/* 打开 acct 时注册 notifier，失败则写参数返回错误、acct 保持关闭 */
+static int acct_param_set(const char *val, const struct kernel_param *kp)
+{
+    bool on;
+    int ret;
+
+    ret = kstrtobool(val, &on);
+    if (ret)
+        return ret;
+
+    mutex_lock(&transition_lock);
+    if (on && !acct)
+        ret = transition_get();
+    else if (!on && acct)
+        transition_put();
+    if (!ret)
+        WRITE_ONCE(acct, on);
+    mutex_unlock(&transition_lock);
+    return ret;
+}
+
+int sched_cpufreq_complete_reg(void)
+{
+    int ret;
+
+    mutex_lock(&transition_lock);
+    ret = transition_get();
+    mutex_unlock(&transition_lock);
+    return ret;
+}
+
+void sched_cpufreq_complete_unreg(void)
+{
+    mutex_lock(&transition_lock);
+    transition_put();
+    mutex_unlock(&transition_lock);
+}
+
+/* 模块加载时：insmod acct=1 或加载期间已启用事件的，现在才注册；失败时关闭 acct 继续加载 */
+static void transition_init(void)
+{
+    mutex_lock(&transition_lock);
+    transition_ready = true;
+    if (transition_sync() && acct) {
+        pr_warn("acct disabled\n");
+        WRITE_ONCE(acct, false);
+        transition_users--;
+    }
+    mutex_unlock(&transition_lock);
+}
+
+static void transition_exit(void)
+{
+    mutex_lock(&transition_lock);
+    transition_ready = false;
+    transition_sync();
+    mutex_unlock(&transition_lock);
+}
+
+/* --- 任务切换处理：notifier 与 tracepoint 两种挂接方式共用 --- */
+static void sched_cpufreq_on_switch(struct task_struct *next)
+{
+    unsigned int freq = 0;
 
     /* 仅对实时任务触发 */
-    if ((next->policy == SCHED_FIFO || next->policy == SCHED_RR) &&
-        next->cpufreq > 0) {
-        target_freq = next->cpufreq;
-        atomic_set(&freq_pending, 1);
-        irq_work_queue(&freq_irq_work);
+    if (next->policy == SCHED_FIFO || next->policy == SCHED_RR)
+        freq = task_freq_hint(next);
+
+    /* 统计需要在每次切换时结束上一段，包括切到非 RT 任务；关闭 acct 后仍要结束正在计时的段 */
+    acct_on_switch(next, READ_ONCE(acct) ? freq : 0);
+
+    if (!freq)
+        return;
+
+    trace_dvfs_rt_switch(smp_processor_id(), next, freq);
+    request_freq(freq, DVFS_SRC_SWITCH);
+    if (READ_ONCE(predict))
+        pred_on_switch(next, freq);
+}
+
+#ifdef SCHED_CPUFREQ_TRACEPOINT
+/* --- 原生 sched_switch tracepoint，无需打补丁的内核 --- */
+static struct tracepoint *sched_switch_tp;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,18,0)
+static void probe_sched_switch(void *data, bool preempt,
+                               struct task_struct *prev,
+                               struct task_struct *next,
+                               unsigned int prev_state)
+#else
+static void probe_sched_switch(void *data, bool preempt,
+                               struct task_struct *prev,
+                               struct task_struct *next)
+#endif
+{
+    sched_cpufreq_on_switch(next);
+}
+
+static void find_sched_switch(struct tracepoint *tp, void *priv)
+{
+    if (!strcmp(tp->name, "sched_switch"))
+        sched_switch_tp = tp;
+}
+
+static int switch_hook_register(void)
+{
+    /* __tracepoint_sched_switch 未导出给模块，按名字查找 */
+    for_each_kernel_tracepoint(find_sched_switch, NULL);
+    if (!sched_switch_tp) {
+        pr_err("sched_switch tracepoint not found\n");
+        return -ENOENT;
     }
+    return tracepoint_probe_register(sched_switch_tp, probe_sched_switch, NULL);
+}
 
+static void switch_hook_unregister(void)
+{
+    tracepoint_probe_unregister(sched_switch_tp, probe_sched_switch, NULL);
+    tracepoint_synchronize_unregister();
+}
+#else
+/* --- Notifier 回调 --- */
+static int cpufreq_task_switch_cb(struct notifier_block *nb,
+                                  unsigned long val, void *data)
+{
+    sched_cpufreq_on_switch(data);
     return NOTIFY_OK;
 }
 
@@ -88,37 +1044,285 @@ static struct notifier_block cpufreq_nb = {
     .notifier_call = cpufreq_task_switch_cb,
 };
 
+static int switch_hook_register(void)
+{
+    return raw_notifier_chain_register(&cpufreq_task_switch_notifier, &cpufreq_nb);
+}
+
+static void switch_hook_unregister(void)
+{
+    raw_notifier_chain_unregister(&cpufreq_task_switch_notifier, &cpufreq_nb);
+    /* 回调运行在关抢占的调度路径中，等待其全部退出 */
+    synchronize_rcu();
+}
+#endif
+
+/* --- ioctl: 设置/查询每任务频率提示 --- */
+static long hint_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    struct sched_cpufreq_hint data;
+
+    /* 共享结构的注册/注销只作用于调用线程自身 */
+    if (cmd == IOCTL_SHM_REGISTER)
+        return hint_shm_register(file, arg);
+    if (cmd == IOCTL_SHM_UNREGISTER)
+        return hint_shm_drop(NULL, current);
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+        return -EFAULT;
+    if (data.pid < 0)
+        return -EINVAL;
+    if (!data.pid)
+        data.pid = task_pid_nr(current);
+
+    switch (cmd) {
+    case IOCTL_SET_HINT:
+        return hint_set(data.pid, data.freq);
+    case IOCTL_GET_HINT:
+        data.freq = hint_lookup(data.pid, NULL, false);
+        if (copy_to_user((void __user *)arg, &data, sizeof(data)))
+            return -EFAULT;
+        return 0;
+    default:
+        return -EINVAL;
+    }
+}
+
+/* fd 关闭（含进程退出）时自动注销经由它注册的共享结构 */
+static int hint_release(struct inode *inode, struct file *file)
+{
+    hint_shm_drop(file, NULL);
+    return 0;
+}
+
+static const struct file_operations hint_fops = {
+    .owner = THIS_MODULE,
+    .unlocked_ioctl = hint_ioctl,
+    .release = hint_release,
+};
+
+static int hint_dev_create(void)
+{
+    int ret;
+
+    ret = alloc_chrdev_region(&hint_devt, 0, 1, DEVICE_NAME);
+    if (ret)
+        return ret;
+
+    cdev_init(&hint_cdev, &hint_fops);
+    ret = cdev_add(&hint_cdev, hint_devt, 1);
+    if (ret)
+        goto err_unregister;
+
+    hint_class = class_create(THIS_MODULE, CLASS_NAME);
+    if (IS_ERR(hint_class)) {
+        ret = PTR_ERR(hint_class);
+        goto err_cdev;
+    }
+
+    device_create(hint_class, NULL, hint_devt, NULL, DEVICE_NAME);
+    return 0;
+
+err_cdev:
+    cdev_del(&hint_cdev);
+err_unregister:
+    unregister_chrdev_region(hint_devt, 1);
+    return ret;
+}
+
+static void hint_dev_destroy(void)
+{
+    device_destroy(hint_class, hint_devt);
+    class_destroy(hint_class);
+    cdev_del(&hint_cdev);
+    unregister_chrdev_region(hint_devt, 1);
+}
+
+/* --- /proc/sched_cpufreq_pred: 每任务预测统计 --- */
+static int pred_proc_show(struct seq_file *m, void *v)
+{
+    unsigned long flags;
+    int i;
+
+    seq_printf(m, "predict=%d lead_us=%u tol_us=%u\n",
+               READ_ONCE(predict), READ_ONCE(lead_us), READ_ONCE(tol_us));
+    seq_printf(m, "%-7s %-16s %8s %12s %8s %8s %8s %12s\n",
+               "pid", "comm", "freq", "period_ns", "acts", "hits", "misses", "last_err_ns");
+
+    raw_spin_lock_irqsave(&pred_lock, flags);
+    for (i = 0; i < PRED_SLOTS; i++) {
+        struct pred_entry *e = &pred_tbl[i];
+
+        if (!e->pid)
+            continue;
+        seq_printf(m, "%-7d %-16s %8u %12llu %8lu %8lu %8lu %12lld\n",
+                   e->pid, e->comm, e->freq, e->period_ns,
+                   e->activations, e->hits, e->misses, e->last_err_ns);
+    }
+    raw_spin_unlock_irqrestore(&pred_lock, flags);
+    return 0;
+}
+
+static int pred_proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, pred_proc_show, NULL);
+}
+
+static const struct proc_ops pred_proc_ops = {
+    .proc_open    = pred_proc_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* --- /proc/sched_cpufreq_acct: 每任务频率驻留统计 --- */
+static int acct_proc_show(struct seq_file *m, void *v)
+{
+    unsigned long flags;
+    int i, j;
+
+    seq_printf(m, "%-7s %-16s %8s %14s %14s %6s  steps(kHz:ns)\n",
+               "pid", "comm", "req", "total_ns", "below_ns", "below%");
+
+    for (i = 0; i < ACCT_SLOTS; i++) {
+        struct acct_entry snap, *e = &snap;
+
+        /* 逐槽拷贝快照，打印不在关中断的自旋锁内进行 */
+        raw_spin_lock_irqsave(&acct_tbl[i].lock, flags);
+        snap = acct_tbl[i];
+        raw_spin_unlock_irqrestore(&acct_tbl[i].lock, flags);
+
+        if (!e->pid)
+            continue;
+        seq_printf(m, "%-7d %-16s %8u %14llu %14llu %6llu ",
+                   e->pid, e->comm, e->req_freq, e->total_ns, e->below_ns,
+                   e->total_ns ? div64_u64(e->below_ns * 100, e->total_ns) : 0);
+        for (j = 0; j < ACCT_STEPS && e->steps[j].freq; j++)
+            seq_printf(m, " %u:%llu", e->steps[j].freq, e->steps[j].ns);
+        if (e->other_ns)
+            seq_printf(m, " other:%llu", e->other_ns);
+        seq_putc(m, '\n');
+    }
+    return 0;
+}
+
+static int acct_proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, acct_proc_show, NULL);
+}
+
+static const struct proc_ops acct_proc_ops = {
+    .proc_open    = acct_proc_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* 初始化统计锁，并用各 CPU 当前频率初始化统计状态 */
+static void acct_init_cpus(void)
+{
+    int i, cpu;
+
+    for (i = 0; i < ACCT_SLOTS; i++)
+        raw_spin_lock_init(&acct_tbl[i].lock);
+
+    for_each_possible_cpu(cpu) {
+        struct acct_cpu *ac = per_cpu_ptr(&acct_cpu, cpu);
+
+        raw_spin_lock_init(&ac->lock);
+        ac->cur = NULL;
+        ac->cur_freq = cpufreq_quick_get(cpu);
+    }
+}
+
 /* --- 模块初始化 --- */
 static int __init sched_cpufreq_init(void)
 {
+    int i, ret;
+
     pr_info("Initializing sched_cpufreq_update module (CPU1 -> CPU0)\n");
 
     atomic_set(&freq_pending, 0);
     init_irq_work(&freq_irq_work, freq_irq_work_func);
 
+    for (i = 0; i < PRED_SLOTS; i++) {
+        hrtimer_init(&pred_tbl[i].timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_HARD);
+        pred_tbl[i].timer.function = pred_timer_fn;
+    }
+
+    if (!proc_create(PRED_PROC_NAME, 0444, NULL, &pred_proc_ops)) {
+        pr_err("Failed to create /proc/%s\n", PRED_PROC_NAME);
+        return -ENOMEM;
+    }
+
+    acct_init_cpus();
+    if (!proc_create(ACCT_PROC_NAME, 0444, NULL, &acct_proc_ops)) {
+        pr_err("Failed to create /proc/%s\n", ACCT_PROC_NAME);
+        ret = -ENOMEM;
+        goto err_proc;
+    }
+
+    transition_init();
+
+    exit_hook_register();
+    ret = hint_dev_create();
+    if (ret) {
+        pr_err("Failed to create /dev/%s: %d\n", DEVICE_NAME, ret);
+        goto err_exit_hook;
+    }
+
     /* 创建线程绑定 CPU1 */
     freq_kthread = kthread_create(freq_thread_fn, NULL, "freq_thread_cpu1");
     if (IS_ERR(freq_kthread)) {
         pr_err("Failed to create freq_thread\n");
-        return PTR_ERR(freq_kthread);
+        ret = PTR_ERR(freq_kthread);
+        goto err_dev;
     }
     kthread_bind(freq_kthread, 1);
     wake_up_process(freq_kthread);
 
-    /* 注册回调到内核 notifier 链 */
-    raw_notifier_chain_register(&cpufreq_task_switch_notifier, &cpufreq_nb);
+    /* 挂接调度切换：notifier 链或 sched_switch tracepoint */
+    ret = switch_hook_register();
+    if (ret)
+        goto err_thread;
 
     return 0;
+
+err_thread:
+    kthread_stop(freq_kthread);
+err_dev:
+    hint_dev_destroy();
+err_exit_hook:
+    exit_hook_unregister();
+    transition_exit();
+    remove_proc_entry(ACCT_PROC_NAME, NULL);
+err_proc:
+    remove_proc_entry(PRED_PROC_NAME, NULL);
+    return ret;
 }
 
 /* --- 模块卸载 --- */
 static void __exit sched_cpufreq_exit(void)
 {
+    int i;
+
+    /* 先注销回调，再停止定时器与线程，避免卸载后仍有人排队 irq_work */
+    switch_hook_unregister();
+
+    for (i = 0; i < PRED_SLOTS; i++)
+        hrtimer_cancel(&pred_tbl[i].timer);
+    irq_work_sync(&freq_irq_work);
+
     if (freq_kthread)
         kthread_stop(freq_kthread);
 
-    /* 注销回调 */
-    raw_notifier_chain_unregister(&cpufreq_task_switch_notifier, &cpufreq_nb);
+    hint_dev_destroy();
+    exit_hook_unregister();    /* 等待退出回调结束并回收其摘下的注册 */
+    hint_clear_all();
+    rcu_barrier();      /* 等待 kfree_rcu 完成后再卸载代码 */
+    transition_exit();
+    remove_proc_entry(ACCT_PROC_NAME, NULL);
+    remove_proc_entry(PRED_PROC_NAME, NULL);
 
     pr_info("sched_cpufreq_update module unloaded\n");
 }
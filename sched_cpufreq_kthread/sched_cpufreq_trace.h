@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* sched_cpufreq_trace.h: RT 切换与调频请求/执行/完成的 tracepoint */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM sched_cpufreq
+
+#if !defined(_SCHED_CPUFREQ_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _SCHED_CPUFREQ_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/sched.h>
+
+/* DVFS_SRC_* 来源编号与 dvfs_freq_* 事件布局与 cpufreq_ctl、cpufreq_sim 共用 */
+#include "dvfs_trace_common.h"
+
+/* 提交请求：old 为目标 CPU 当前频率，new 为请求频率 */
+DEFINE_DVFS_FREQ_REQUEST_EVENT(dvfs_freq_request);
+
+/* 调频线程执行完 cpufreq_driver_target()：new 为执行后的 policy->cur，latency_ns 自请求起计 */
+DEFINE_DVFS_FREQ_DONE_EVENT(dvfs_freq_apply);
+
+/*
+ * 频率切换完成（POSTCHANGE）：非本模块发起的切换 source 为 other，latency_ns 为 0。
+ * 启用事件时才注册 transition notifier；有 policy 使用 fast switch 时启用失败（-EBUSY）。
+ */
+int sched_cpufreq_complete_reg(void);
+void sched_cpufreq_complete_unreg(void);
+DEFINE_DVFS_FREQ_DONE_EVENT_FN(dvfs_freq_complete, sched_cpufreq_complete_reg,
+                               sched_cpufreq_complete_unreg);
+
+/* 切入带频率提示的 RT 任务 */
+TRACE_EVENT(dvfs_rt_switch,
+
+    TP_PROTO(unsigned int cpu, struct task_struct *next, unsigned int freq),
+
+    TP_ARGS(cpu, next, freq),
+
+    TP_STRUCT__entry(
+        __field(unsigned int,   cpu)
+        __field(pid_t,          pid)
+        __array(char,           comm, TASK_COMM_LEN)
+        __field(int,            prio)
+        __field(unsigned int,   freq)
+    ),
+
+    TP_fast_assign(
+        __entry->cpu  = cpu;
+        __entry->pid  = next->pid;
+        memcpy(__entry->comm, next->comm, TASK_COMM_LEN);
+        __entry->prio = next->prio;
+        __entry->freq = freq;
+    ),
+
+    TP_printk("cpu=%u pid=%d comm=%s prio=%d freq=%u",
+              __entry->cpu, __entry->pid, __entry->comm, __entry->prio, __entry->freq)
+);
+
+#endif /* _SCHED_CPUFREQ_TRACE_H */
+
+/* 头文件与模块源码同目录，Makefile 中需 -I$(src) */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE sched_cpufreq_trace
+#include <trace/define_trace.h>